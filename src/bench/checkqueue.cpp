@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <checkqueue.h>
 #include <common/system.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <random.h>
@@ -66,3 +67,47 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     });
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, benchmark::PriorityLevel::HIGH);
+
+// This Benchmark measures how the CheckQueue scales with the number of
+// threads, using checks that each do a few microseconds of hashing, roughly
+// like a signature check, submitted in per-transaction batches.
+static void CCheckQueueScaling(benchmark::Bench& bench, int threads_num)
+{
+    struct HashJob {
+        uint8_t data[64]{};
+        std::optional<int> operator()()
+        {
+            for (int i = 0; i < 16; ++i) {
+                CSHA256().Write(data, sizeof(data)).Finalize(data);
+            }
+            return std::nullopt;
+        }
+    };
+
+    CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE, threads_num - 1};
+    const std::vector<std::vector<HashJob>> vBatches(BATCHES, std::vector<HashJob>(BATCH_SIZE));
+
+    bench.minEpochIterations(10).batch(BATCH_SIZE * BATCHES).unit("job").run([&] {
+        CCheckQueueControl<HashJob> control(queue);
+        for (auto vChecks : vBatches) {
+            control.Add(std::move(vChecks));
+        }
+        control.Complete();
+    });
+}
+
+static void CCheckQueueScaling1Thread(benchmark::Bench& bench) { CCheckQueueScaling(bench, 1); }
+static void CCheckQueueScaling2Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 2); }
+static void CCheckQueueScaling4Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 4); }
+static void CCheckQueueScaling8Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 8); }
+static void CCheckQueueScaling16Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 16); }
+static void CCheckQueueScaling32Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 32); }
+static void CCheckQueueScaling64Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 64); }
+
+BENCHMARK(CCheckQueueScaling1Thread, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling2Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling4Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling8Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling16Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling32Threads, benchmark::PriorityLevel::LOW);
+BENCHMARK(CCheckQueueScaling64Threads, benchmark::PriorityLevel::LOW);
@@ -9,9 +9,11 @@
 #include <script/interpreter.h>
 #include <sync.h>
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
 #include <validation.h>
 
 #include <cassert>
+#include <string>
 #include <vector>
 
 /*
@@ -126,6 +128,69 @@ static void ConnectBlockAllEcdsa(benchmark::Bench& bench)
     BenchmarkConnectBlock(bench, keys, outputs, *test_setup);
 }
 
+/*
+ * Reconnects a chain of blocks read back from disk, as during IBD, with every
+ * block's inputs fetched from the coins database rather than the cache.
+ * Each block spends all outputs created by the previous one, plus a coinbase.
+ * The measured time includes disconnecting the blocks and flushing the cache
+ * before they are connected again.
+ */
+static void BenchmarkConnectBlocksFromDisk(benchmark::Bench& bench, bool connect_pipeline)
+{
+    const std::string pipeline_arg{strprintf("-connectpipeline=%d", connect_pipeline)};
+    const auto test_setup{MakeNoLogFileContext<TestChain100Setup>(ChainType::REGTEST, {.extra_args = {pipeline_arg.c_str()}, .coins_db_in_memory = false})};
+    auto& chainman{*test_setup->m_node.chainman};
+    Chainstate& chainstate{chainman.ActiveChainstate()};
+    auto [keys, outputs]{CreateKeysAndOutputs(test_setup->coinbaseKey, /*num_schnorr=*/20, /*num_ecdsa=*/20)};
+    const CScript coinbase_spk{GetScriptForDestination(WitnessV1Taproot{XOnlyPubKey(test_setup->coinbaseKey.GetPubKey())})};
+
+    constexpr int NUM_BLOCKS{10};
+    CTransactionRef prev_fanout;
+    for (int i{0}; i < NUM_BLOCKS; ++i) {
+        const int height{WITH_LOCK(cs_main, return chainstate.m_chain.Height()) + 1};
+        std::vector<CMutableTransaction> txs;
+        const auto& coinbase_to_spend{test_setup->m_coinbase_txns[i]};
+        const auto fanout{test_setup->CreateValidTransaction(
+            {coinbase_to_spend}, {COutPoint(coinbase_to_spend->GetHash(), 0)}, i + 1, keys, outputs, {}, {}).first};
+        txs.emplace_back(fanout);
+        if (prev_fanout) {
+            std::vector<COutPoint> inputs;
+            for (size_t j{0}; j < prev_fanout->vout.size(); ++j) inputs.emplace_back(prev_fanout->GetHash(), j);
+            txs.emplace_back(test_setup->CreateValidTransaction(
+                {prev_fanout}, inputs, height - 1, keys, {CTxOut(COIN, coinbase_spk)}, {}, {}).first);
+        }
+        prev_fanout = MakeTransactionRef(fanout);
+        test_setup->CreateAndProcessBlock(txs, coinbase_spk, &chainstate);
+    }
+
+    CBlockIndex* first{WITH_LOCK(cs_main, return chainstate.m_chain[chainstate.m_chain.Height() - NUM_BLOCKS + 1])};
+    const CBlockIndex* last{WITH_LOCK(cs_main, return chainstate.m_chain.Tip())};
+    bench.batch(NUM_BLOCKS).unit("block").run([&] {
+        BlockValidationState state;
+        assert(chainstate.InvalidateBlock(state, first));
+        {
+            LOCK(cs_main);
+            chainstate.ForceFlushStateToDisk();
+            chainstate.ResetBlockFailureFlags(first);
+            chainman.RecalculateBestHeader();
+        }
+        assert(chainstate.ActivateBestChain(state));
+        assert(WITH_LOCK(cs_main, return chainstate.m_chain.Tip()) == last);
+    });
+}
+
+static void ConnectBlocksFromDiskPipelined(benchmark::Bench& bench)
+{
+    BenchmarkConnectBlocksFromDisk(bench, /*connect_pipeline=*/true);
+}
+
+static void ConnectBlocksFromDiskSerial(benchmark::Bench& bench)
+{
+    BenchmarkConnectBlocksFromDisk(bench, /*connect_pipeline=*/false);
+}
+
 BENCHMARK(ConnectBlockAllSchnorr, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ConnectBlockMixedEcdsaSchnorr, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ConnectBlockAllEcdsa, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ConnectBlocksFromDiskPipelined, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ConnectBlocksFromDiskSerial, benchmark::PriorityLevel::HIGH);
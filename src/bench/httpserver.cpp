@@ -0,0 +1,170 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <common/args.h>
+#include <httpserver.h>
+#include <netaddress.h>
+#include <netbase.h>
+#include <random.h>
+#include <rpc/protocol.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/check.h>
+#include <util/signalinterrupt.h>
+#include <util/sock.h>
+#include <util/strencodings.h>
+#include <util/threadinterrupt.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+//! Time a slow request takes, like a long running RPC call.
+constexpr auto SLOW_REQUEST_TIME{20ms};
+
+CThreadInterrupt g_interrupt;
+
+//! A keep-alive HTTP connection to the server under test.
+class HTTPClient
+{
+    std::unique_ptr<Sock> m_sock;
+    std::string m_auth;
+
+public:
+    HTTPClient(const CService& server, std::string auth) : m_sock{ConnectDirectly(server, /*manual_connection=*/true)}, m_auth{std::move(auth)}
+    {
+        Assert(m_sock);
+    }
+
+    void SendRequest(const std::string& path)
+    {
+        const std::string request{strprintf("GET %s HTTP/1.1\r\nHost: localhost\r\nAuthorization: %s\r\n\r\n", path, m_auth)};
+        m_sock->SendComplete(std::span{request}, 5s, g_interrupt);
+    }
+
+    //! Read a reply. Bodies are a single line, so the reply ends at the first
+    //! newline after the headers.
+    void ReceiveReply()
+    {
+        while (m_sock->RecvUntilTerminator('\n', 5s, g_interrupt, 1024) != "\r") {}
+        (void)m_sock->RecvUntilTerminator('\n', 5s, g_interrupt, 1024);
+    }
+};
+
+//! Serves /cheap requests immediately and /slow ones after SLOW_REQUEST_TIME,
+//! with rpc_threads workers, on a loopback port.
+class HTTPServerSetup
+{
+    const std::unique_ptr<const BasicTestingSetup> m_testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    util::SignalInterrupt m_interrupt;
+
+public:
+    CService m_server;
+
+    HTTPServerSetup(int rpc_threads, int rpc_client_threads)
+    {
+        gArgs.ForceSetArg("-rpcthreads", strprintf("%d", rpc_threads));
+        gArgs.ForceSetArg("-rpcclientthreads", strprintf("%d", rpc_client_threads));
+        gArgs.ForceSetArg("-rpcworkqueue", "1000");
+        const uint16_t port{static_cast<uint16_t>(20000 + FastRandomContext{}.randrange(10000))};
+        gArgs.ForceSetArg("-rpcport", strprintf("%d", port));
+        Assert(InitHTTPServer(m_interrupt));
+        RegisterHTTPHandler("/cheap", true, [](HTTPRequest* req, const std::string&) {
+            req->WriteReply(HTTP_OK, "ok\n");
+            return true;
+        });
+        RegisterHTTPHandler("/slow", true, [](HTTPRequest* req, const std::string&) {
+            std::this_thread::sleep_for(SLOW_REQUEST_TIME);
+            req->WriteReply(HTTP_OK, "ok\n");
+            return true;
+        });
+        StartHTTPServer();
+        m_server = LookupNumeric("127.0.0.1", port);
+    }
+
+    ~HTTPServerSetup()
+    {
+        InterruptHTTPServer();
+        StopHTTPServer();
+        UnregisterHTTPHandler("/cheap", true);
+        UnregisterHTTPHandler("/slow", true);
+    }
+};
+
+//! Keeps the server busy with the slow requests of a single client while
+//! running.
+class SlowLoad
+{
+    std::atomic<bool> m_stop{false};
+    std::thread m_thread;
+
+public:
+    SlowLoad(const CService& server, int connections)
+    {
+        std::vector<HTTPClient> clients;
+        for (int i{0}; i < connections; ++i) clients.emplace_back(server, "slow");
+        m_thread = std::thread{[this, clients = std::move(clients)]() mutable {
+            while (!m_stop) {
+                for (auto& client : clients) client.SendRequest("/slow");
+                for (auto& client : clients) client.ReceiveReply();
+            }
+        }};
+    }
+
+    ~SlowLoad()
+    {
+        m_stop = true;
+        m_thread.join();
+    }
+};
+
+} // namespace
+
+//! Throughput of cheap requests sent over many concurrent keep-alive
+//! connections.
+static void HTTPServerThroughput(benchmark::Bench& bench)
+{
+    constexpr int CONNECTIONS{64};
+    HTTPServerSetup setup{/*rpc_threads=*/4, /*rpc_client_threads=*/0};
+    std::vector<HTTPClient> clients;
+    for (int i{0}; i < CONNECTIONS; ++i) clients.emplace_back(setup.m_server, strprintf("client%d", i));
+
+    bench.batch(CONNECTIONS).unit("request").run([&] {
+        for (auto& client : clients) client.SendRequest("/cheap");
+        for (auto& client : clients) client.ReceiveReply();
+    });
+}
+
+//! Time until the slowest of many concurrent cheap requests is answered,
+//! i.e. their tail latency, while another client keeps the server busy
+//! with slow requests.
+static void HTTPServerTailLatency(benchmark::Bench& bench, int rpc_client_threads)
+{
+    constexpr int RPC_THREADS{4};
+    constexpr int CONNECTIONS{64};
+    HTTPServerSetup setup{RPC_THREADS, rpc_client_threads};
+    std::vector<HTTPClient> clients;
+    for (int i{0}; i < CONNECTIONS; ++i) clients.emplace_back(setup.m_server, "cheap");
+    const SlowLoad load{setup.m_server, RPC_THREADS * 2};
+
+    bench.unit("burst").run([&] {
+        for (auto& client : clients) client.SendRequest("/cheap");
+        for (auto& client : clients) client.ReceiveReply();
+    });
+}
+
+static void HTTPServerTailLatencyShared(benchmark::Bench& bench) { HTTPServerTailLatency(bench, /*rpc_client_threads=*/0); }
+static void HTTPServerTailLatencyPerClient(benchmark::Bench& bench) { HTTPServerTailLatency(bench, /*rpc_client_threads=*/3); }
+
+BENCHMARK(HTTPServerThroughput, benchmark::PriorityLevel::LOW);
+BENCHMARK(HTTPServerTailLatencyShared, benchmark::PriorityLevel::LOW);
+BENCHMARK(HTTPServerTailLatencyPerClient, benchmark::PriorityLevel::LOW);
@@ -65,6 +65,43 @@ static void ReadRawBlockBench(benchmark::Bench& bench)
     });
 }
 
+//! Write the block until its first block file is full, and return its position there.
+static FlatFilePos WriteToFinalizedFile(node::BlockManager& blockman, const CBlock& block)
+{
+    const auto pos{blockman.WriteBlock(block, 413'567)};
+    while (blockman.WriteBlock(block, 413'567).nFile == pos.nFile) {}
+    return pos;
+}
+
+static void ReadBlockMappedBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN)};
+    auto& blockman{testing_setup->m_node.chainman->m_blockman};
+    const auto& test_block{CreateTestBlock()};
+    const auto& expected_hash{test_block.GetHash()};
+    const auto pos{WriteToFinalizedFile(blockman, test_block)};
+    bench.run([&] {
+        CBlock block;
+        const auto success{blockman.ReadBlock(block, pos, expected_hash)};
+        assert(success);
+    });
+}
+
+static void ReadRawBlockMappedBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN)};
+    auto& blockman{testing_setup->m_node.chainman->m_blockman};
+    const auto pos{WriteToFinalizedFile(blockman, CreateTestBlock())};
+    std::vector<std::byte> block_data;
+    blockman.ReadRawBlock(block_data, pos); // warmup
+    bench.run([&] {
+        const auto success{blockman.ReadRawBlock(block_data, pos)};
+        assert(success);
+    });
+}
+
 BENCHMARK(WriteBlockBench, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ReadBlockBench, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ReadRawBlockBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ReadBlockMappedBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ReadRawBlockMappedBench, benchmark::PriorityLevel::HIGH);
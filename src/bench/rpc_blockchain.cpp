@@ -9,6 +9,7 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
@@ -17,8 +18,11 @@
 #include <univalue.h>
 #include <validation.h>
 
+#include <cassert>
 #include <cstddef>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace {
@@ -86,3 +90,35 @@ static void BlockToJsonVerboseWrite(benchmark::Bench& bench)
 }
 
 BENCHMARK(BlockToJsonVerboseWrite, benchmark::PriorityLevel::HIGH);
+
+static void BlockToJsonVerboseParse(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    const uint256 pow_limit{data.testing_setup->m_node.chainman->GetParams().GetConsensus().powLimit};
+    const std::string json{blockToJSON(data.testing_setup->m_node.chainman->m_blockman, data.block, data.blockindex, data.blockindex, TxVerbosity::SHOW_DETAILS_AND_PREVOUT, pow_limit).write()};
+    bench.batch(json.size()).unit("byte").run([&] {
+        UniValue univalue;
+        bool ok{univalue.read(json)};
+        assert(ok);
+        ankerl::nanobench::doNotOptimizeAway(univalue);
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseParse, benchmark::PriorityLevel::HIGH);
+
+//! Equivalent of BlockToJsonVerbosity3 followed by BlockToJsonVerboseWrite,
+//! streaming the JSON out in chunks instead.
+static void BlockToJsonVerboseStream(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    const uint256 pow_limit{data.testing_setup->m_node.chainman->GetParams().GetConsensus().powLimit};
+    bench.run([&] {
+        size_t size{0};
+        JSONStreamWriter out{[&](std::string_view chunk) { size += chunk.size(); }};
+        blockToJSON(data.testing_setup->m_node.chainman->m_blockman, data.block, data.blockindex, data.blockindex, TxVerbosity::SHOW_DETAILS_AND_PREVOUT, pow_limit, out);
+        out.Flush();
+        ankerl::nanobench::doNotOptimizeAway(size);
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseStream, benchmark::PriorityLevel::HIGH);
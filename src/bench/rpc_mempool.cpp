@@ -6,6 +6,7 @@
 #include <consensus/amount.h>
 #include <kernel/cs_main.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
 #include <rpc/mempool.h>
 #include <script/script.h>
 #include <sync.h>
@@ -16,6 +17,7 @@
 #include <util/check.h>
 
 #include <memory>
+#include <string_view>
 #include <vector>
 
 
@@ -25,12 +27,8 @@ static void AddTx(const CTransactionRef& tx, const CAmount& fee, CTxMemPool& poo
     AddToMempool(pool, CTxMemPoolEntry(tx, fee, /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0, /*spends_coinbase=*/false, /*sigops_cost=*/4, lp));
 }
 
-static void RpcMempool(benchmark::Bench& bench)
+static void AddTxs(CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
 {
-    const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(ChainType::MAIN);
-    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
-    LOCK2(cs_main, pool.cs);
-
     for (int i = 0; i < 1000; ++i) {
         CMutableTransaction tx = CMutableTransaction();
         tx.vin.resize(1);
@@ -42,10 +40,37 @@ static void RpcMempool(benchmark::Bench& bench)
         const CTransactionRef tx_r{MakeTransactionRef(tx)};
         AddTx(tx_r, /*fee=*/i, pool);
     }
+}
+
+static void RpcMempool(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+
+    AddTxs(pool);
 
     bench.run([&] {
         (void)MempoolToJSON(pool, /*verbose=*/true);
     });
 }
 
+static void RpcMempoolStream(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+
+    AddTxs(pool);
+
+    bench.run([&] {
+        size_t size{0};
+        JSONStreamWriter out{[&](std::string_view chunk) { size += chunk.size(); }};
+        MempoolToJSON(pool, out);
+        out.Flush();
+        ankerl::nanobench::doNotOptimizeAway(size);
+    });
+}
+
 BENCHMARK(RpcMempool, benchmark::PriorityLevel::HIGH);
+BENCHMARK(RpcMempoolStream, benchmark::PriorityLevel::HIGH);
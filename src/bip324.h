@@ -24,6 +24,8 @@ public:
     static constexpr unsigned REKEY_INTERVAL{224};
     static constexpr unsigned LENGTH_LEN{3};
     static constexpr unsigned HEADER_LEN{1};
+    //! Maximum length of the contents prefix accepted by Encrypt(), enough for an encoded message type.
+    static constexpr unsigned MAX_CONTENTS_PREFIX_LEN{16};
     static constexpr unsigned EXPANSION = LENGTH_LEN + HEADER_LEN + FSChaCha20Poly1305::EXPANSION;
     static constexpr std::byte IGNORE_BIT{0x80};
 
@@ -70,6 +72,14 @@ public:
      */
     void Encrypt(std::span<const std::byte> contents, std::span<const std::byte> aad, bool ignore, std::span<std::byte> output) noexcept;
 
+    /** Encrypt a packet whose contents are a short prefix followed by the rest, without
+     *  concatenating them first. Only after Initialize().
+     *
+     * It must hold that prefix.size() <= MAX_CONTENTS_PREFIX_LEN and
+     * output.size() == prefix.size() + contents.size() + EXPANSION.
+     */
+    void Encrypt(std::span<const std::byte> prefix, std::span<const std::byte> contents, std::span<const std::byte> aad, bool ignore, std::span<std::byte> output) noexcept;
+
     /** Decrypt the length of a packet. Only after Initialize().
      *
      * It must hold that input.size() == LENGTH_LEN.
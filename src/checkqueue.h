@@ -11,8 +11,15 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <iterator>
+#include <memory>
 #include <optional>
+#include <thread>
+#include <utility>
 #include <vector>
 
 /**
@@ -28,12 +35,45 @@
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
   *
+  * Every thread owns a deque of pending verifications, and Add() spreads new
+  * verifications over them. Threads take batches from the back of their own
+  * deque and, once it is empty, steal from the front of the others. Each
+  * deque has its own lock, so threads only contend when they touch the same
+  * deque, and the shared mutex is only taken to go to sleep or wake up.
+  *
   */
 template <typename T, typename R = std::remove_cvref_t<decltype(std::declval<T>()().value())>>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! The pending verifications of one thread.
+    struct WorkQueue {
+        Mutex m_mutex;
+        //! The owner takes from the back, other threads steal from the front.
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+    };
+
+    //! One WorkQueue per worker thread, followed by one for the master.
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    //! The WorkQueue the next Add() starts distributing verifications at.
+    size_t m_next_queue{0};
+
+    /**
+     * Number of verifications that haven't completed yet.
+     * This includes elements that are no longer queued, but still in a
+     * thread's own batch.
+     */
+    std::atomic<unsigned int> m_todo{0};
+
+    //! Whether m_result is set; remaining verifications are skipped then.
+    std::atomic_bool m_have_result{false};
+
+    Mutex m_result_mutex;
+    //! The temporary evaluation result.
+    std::optional<R> m_result GUARDED_BY(m_result_mutex);
+
+    //! Mutex to protect sleeping and waking up
     Mutex m_mutex;
 
     //! Worker threads block on this when out of work
@@ -42,25 +82,11 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
-
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
+    //! Incremented by every Add(); idle workers sleep until it changes.
+    std::atomic<uint64_t> m_epoch{0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
-
-    //! The temporary evaluation result.
-    std::optional<R> m_result GUARDED_BY(m_mutex);
-
-    /**
-     * Number of verifications that haven't completed yet.
-     * This includes elements that are no longer queued, but still in the
-     * worker's own batches.
-     */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    //! The number of worker threads that are about to sleep or sleeping.
+    std::atomic<int> m_idle{0};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
@@ -68,72 +94,78 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /** Take half of the given queue's verifications, at most nBatchSize, from its back or front. */
+    bool TakeBatch(WorkQueue& queue, bool from_back, std::vector<T>& batch) EXCLUSIVE_LOCKS_REQUIRED(!queue.m_mutex)
+    {
+        LOCK(queue.m_mutex);
+        auto& checks{queue.m_checks};
+        if (checks.empty()) return false;
+        const size_t n{std::clamp<size_t>(checks.size() / 2, 1, nBatchSize)};
+        const auto first{from_back ? checks.end() - n : checks.begin()};
+        batch.assign(std::make_move_iterator(first), std::make_move_iterator(first + n));
+        checks.erase(first, first + n);
+        return true;
+    }
+
+    /** Fill batch from the thread's own queue, or else steal from another one. */
+    void FindWork(size_t self, std::vector<T>& batch)
+    {
+        if (TakeBatch(*m_queues[self], /*from_back=*/true, batch)) return;
+        for (size_t i = 1; i < m_queues.size(); ++i) {
+            if (TakeBatch(*m_queues[(self + i) % m_queues.size()], /*from_back=*/false, batch)) return;
+        }
+    }
+
     /** Internal function that does bulk of the verification work. If fMaster, return the final result. */
-    std::optional<R> Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    std::optional<R> Loop(size_t self, bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex, !m_result_mutex)
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        std::optional<R> local_result;
-        bool do_work;
-        do {
-            {
-                WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    if (local_result.has_value() && !m_result.has_value()) {
-                        std::swap(local_result, m_result);
-                    }
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster) {
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                    }
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        std::optional<R> to_return = std::move(m_result);
-                        // reset the status for new work later
-                        m_result = std::nullopt;
-                        // return the current status
-                        return to_return;
+        while (true) {
+            // Read the epoch before looking for work, so that verifications
+            // added after the search wake this thread up again.
+            const uint64_t epoch{m_epoch.load()};
+            FindWork(self, vChecks);
+            if (!vChecks.empty()) {
+                // Check whether we need to do work at all
+                if (!m_have_result.load()) {
+                    for (T& check : vChecks) {
+                        std::optional<R> local_result{check()};
+                        if (local_result.has_value()) {
+                            LOCK(m_result_mutex);
+                            if (!m_result.has_value()) m_result = std::move(local_result);
+                            m_have_result = true;
+                            break;
+                        }
                     }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
                 }
-                if (m_request_stop) {
-                    // return value does not matter, because m_request_stop is only set in the destructor.
-                    return std::nullopt;
+                const unsigned int nNow = vChecks.size();
+                vChecks.clear();
+                if (m_todo.fetch_sub(nNow) == nNow && !fMaster) {
+                    // We processed the last element; inform the master it can exit and return the result
+                    LOCK(m_mutex);
+                    m_master_cv.notify_one();
                 }
+                continue;
+            }
 
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                auto start_it = queue.end() - nNow;
-                vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(queue.end()));
-                queue.erase(start_it, queue.end());
-                // Check whether we need to do work at all
-                do_work = !m_result.has_value();
+            WAIT_LOCK(m_mutex, lock);
+            if (m_request_stop) {
+                // return value does not matter, because m_request_stop is only set in the destructor.
+                return std::nullopt;
             }
-            // execute work
-            if (do_work) {
-                for (T& check : vChecks) {
-                    local_result = check();
-                    if (local_result.has_value()) break;
-                }
+            if (fMaster) {
+                // Nothing is left to steal; wait for the workers to finish their batches.
+                m_master_cv.wait(lock, [&] { return m_todo.load() == 0; });
+                std::optional<R> to_return{WITH_LOCK(m_result_mutex, return std::exchange(m_result, std::nullopt))};
+                // reset the status for new work later
+                m_have_result = false;
+                return to_return;
             }
-            vChecks.clear();
-        } while (true);
+            ++m_idle;
+            m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_epoch.load() != epoch || m_request_stop; });
+            --m_idle;
+        }
     }
 
 public:
@@ -145,11 +177,15 @@ public:
         : nBatchSize(batch_size)
     {
         LogInfo("Script verification uses %d additional threads", worker_threads_num);
+        m_queues.reserve(worker_threads_num + 1);
+        for (int n = 0; n < worker_threads_num + 1; ++n) {
+            m_queues.push_back(std::make_unique<WorkQueue>());
+        }
         m_worker_threads.reserve(worker_threads_num);
         for (int n = 0; n < worker_threads_num; ++n) {
             m_worker_threads.emplace_back([this, n]() {
                 util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+                Loop(n, false /* worker thread */);
             });
         }
     }
@@ -163,9 +199,9 @@ public:
 
     //! Join the execution until completion. If at least one evaluation wasn't successful, return
     //! its error.
-    std::optional<R> Complete() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    std::optional<R> Complete() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex, !m_result_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(m_queues.size() - 1, true /* master thread */);
     }
 
     //! Add a batch of checks to the queue
@@ -175,12 +211,26 @@ public:
             return;
         }
 
-        {
-            LOCK(m_mutex);
-            queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
-            nTodo += vChecks.size();
+        // Account for the checks before any thread can complete them.
+        m_todo += vChecks.size();
+
+        // Hand out contiguous slices, one per queue, so that every thread
+        // starts out with its own share.
+        const size_t slice{(vChecks.size() + m_queues.size() - 1) / m_queues.size()};
+        for (auto it = vChecks.begin(); it != vChecks.end();) {
+            const auto slice_end{it + std::min<size_t>(slice, vChecks.end() - it)};
+            WorkQueue& queue{*m_queues[m_next_queue]};
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            LOCK(queue.m_mutex);
+            queue.m_checks.insert(queue.m_checks.end(), std::make_move_iterator(it), std::make_move_iterator(slice_end));
+            it = slice_end;
         }
 
+        // Only take the mutex if a worker may be going to sleep: it either
+        // sees the new epoch, or is waiting by the time it is notified.
+        ++m_epoch;
+        if (m_idle.load() == 0) return;
+        LOCK(m_mutex);
         if (vChecks.size() == 1) {
             m_worker_cv.notify_one();
         } else {
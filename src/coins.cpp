@@ -9,11 +9,21 @@
 #include <random.h>
 #include <util/trace.h>
 
+#include <algorithm>
+
 TRACEPOINT_SEMAPHORE(utxocache, add);
 TRACEPOINT_SEMAPHORE(utxocache, spent);
 TRACEPOINT_SEMAPHORE(utxocache, uncache);
 
 std::optional<Coin> CCoinsView::GetCoin(const COutPoint& outpoint) const { return std::nullopt; }
+std::vector<std::optional<Coin>> CCoinsView::GetCoins(std::span<const COutPoint> outpoints) const
+{
+    std::vector<std::optional<Coin>> coins;
+    coins.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) coins.push_back(GetCoin(outpoint));
+    return coins;
+}
+
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
 bool CCoinsView::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashBlock) { return false; }
@@ -42,7 +52,7 @@ CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn, bool deterministic) :
 }
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
-    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+    return memusage::DynamicUsage(cacheCoins) + memusage::DynamicUsage(m_partial_sync_queue) + cachedCoinsUsage;
 }
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
@@ -98,9 +108,11 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
     if (!inserted) {
         cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
     }
+    const bool was_dirty{it->second.IsDirty()};
     it->second.coin = std::move(coin);
     CCoinsCacheEntry::SetDirty(*it, m_sentinel);
     if (fresh) CCoinsCacheEntry::SetFresh(*it, m_sentinel);
+    if (!was_dirty && !it->second.IsFresh()) QueuePartialSync(outpoint);
     cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
     TRACEPOINT(utxocache, add,
            outpoint.hash.data(),
@@ -115,6 +127,7 @@ void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coi
     auto [it, inserted] = cacheCoins.try_emplace(std::move(outpoint), std::move(coin));
     if (inserted) {
         CCoinsCacheEntry::SetDirty(*it, m_sentinel);
+        QueuePartialSync(it->first);
         cachedCoinsUsage += mem_usage;
     }
 }
@@ -146,6 +159,7 @@ bool CCoinsViewCache::SpendCoin(const COutPoint &outpoint, Coin* moveout) {
     if (it->second.IsFresh()) {
         cacheCoins.erase(it);
     } else {
+        if (!it->second.IsDirty()) QueuePartialSync(outpoint);
         CCoinsCacheEntry::SetDirty(*it, m_sentinel);
         it->second.coin.Clear();
     }
@@ -173,6 +187,12 @@ bool CCoinsViewCache::HaveCoinInCache(const COutPoint &outpoint) const {
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
 }
 
+std::optional<Coin> CCoinsViewCache::PeekCoin(const COutPoint& outpoint) const
+{
+    if (auto it{cacheCoins.find(outpoint)}; it != cacheCoins.end()) return it->second.coin;
+    return std::nullopt;
+}
+
 uint256 CCoinsViewCache::GetBestBlock() const {
     if (hashBlock.IsNull())
         hashBlock = base->GetBestBlock();
@@ -211,7 +231,11 @@ bool CCoinsViewCache::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &ha
                 // We can mark it FRESH in the parent if it was FRESH in the child
                 // Otherwise it might have just been flushed from the parent's cache
                 // and already exist in the grandparent
-                if (it->second.IsFresh()) CCoinsCacheEntry::SetFresh(*itUs, m_sentinel);
+                if (it->second.IsFresh()) {
+                    CCoinsCacheEntry::SetFresh(*itUs, m_sentinel);
+                } else {
+                    QueuePartialSync(it->first);
+                }
             }
         } else {
             // Found the entry in the parent cache
@@ -239,6 +263,7 @@ bool CCoinsViewCache::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &ha
                     itUs->second.coin = it->second.coin;
                 }
                 cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
+                if (!itUs->second.IsDirty() && !itUs->second.IsFresh()) QueuePartialSync(it->first);
                 CCoinsCacheEntry::SetDirty(*itUs, m_sentinel);
                 // NOTE: It isn't safe to mark the coin as FRESH in the parent
                 // cache. If it already existed and was spent in the parent
@@ -258,6 +283,7 @@ bool CCoinsViewCache::Flush() {
         cacheCoins.clear();
         ReallocateCache();
         cachedCoinsUsage = 0;
+        m_partial_sync_queue.clear();
     }
     return fOk;
 }
@@ -271,10 +297,32 @@ bool CCoinsViewCache::Sync()
             /* BatchWrite must clear flags of all entries */
             throw std::logic_error("Not all unspent flagged entries were cleared");
         }
+        m_partial_sync_queue.clear();
     }
     return fOk;
 }
 
+std::optional<size_t> CCoinsViewCache::SyncPartial(size_t max_coins)
+{
+    const size_t count{std::min(max_coins, m_partial_sync_queue.size())};
+    auto cursor{CoinsViewCacheCursor(m_sentinel, cacheCoins, std::span{m_partial_sync_queue}.first(count))};
+    // Avoid marking the base as inconsistent when there is nothing to write.
+    if (cursor.Begin() != cursor.End() && !base->BatchWrite(cursor, hashBlock)) return std::nullopt;
+    m_partial_sync_queue.erase(m_partial_sync_queue.begin(), m_partial_sync_queue.begin() + count);
+    return cursor.PartialCount();
+}
+
+void CCoinsViewCache::EnablePartialSync(size_t max_queued)
+{
+    m_max_partial_sync_queue = max_queued;
+    if (m_partial_sync_queue.size() > max_queued) m_partial_sync_queue.resize(max_queued);
+}
+
+void CCoinsViewCache::QueuePartialSync(const COutPoint& outpoint)
+{
+    if (m_partial_sync_queue.size() < m_max_partial_sync_queue) m_partial_sync_queue.push_back(outpoint);
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -390,3 +438,158 @@ bool CCoinsViewErrorCatcher::HaveCoin(const COutPoint& outpoint) const
 {
     return ExecuteBackedWrapper<bool>([&]() { return CCoinsViewBacked::HaveCoin(outpoint); }, m_err_callbacks);
 }
+
+std::vector<std::optional<Coin>> CCoinsViewErrorCatcher::GetCoins(std::span<const COutPoint> outpoints) const
+{
+    return ExecuteBackedWrapper<std::vector<std::optional<Coin>>>([&]() { return base->GetCoins(outpoints); }, m_err_callbacks);
+}
+
+std::optional<Coin> CCoinsViewPrefetch::GetCoin(const COutPoint& outpoint) const
+{
+    {
+        LOCK(m_mutex);
+        if (const auto it{m_pending.find(outpoint)}; it != m_pending.end()) {
+            if (it->second.coin.IsSpent()) return std::nullopt;
+            return it->second.coin;
+        }
+        if (auto node{m_staged.extract(outpoint)}) {
+            ++m_stats.hits;
+            return std::move(node.mapped());
+        }
+    }
+    return base->GetCoin(outpoint);
+}
+
+bool CCoinsViewPrefetch::HaveCoin(const COutPoint& outpoint) const
+{
+    {
+        LOCK(m_mutex);
+        if (const auto it{m_pending.find(outpoint)}; it != m_pending.end()) return !it->second.coin.IsSpent();
+        if (m_staged.contains(outpoint)) return true;
+    }
+    return base->HaveCoin(outpoint);
+}
+
+bool CCoinsViewPrefetch::BatchWrite(CoinsViewCacheCursor& cursor, const uint256& hashBlock)
+{
+    if (cursor.IsPartial()) {
+        // The base already knows all these coins, so holding them back until
+        // WritePending() does not need the staging area to be dropped.
+        LOCK(m_mutex);
+        ++m_pending_seq;
+        for (auto it{cursor.Begin()}; it != cursor.End(); it = cursor.NextAndMaybeErase(*it)) {
+            m_pending.insert_or_assign(it->first, PendingCoin{.coin = it->second.coin, .seq = m_pending_seq});
+            m_stats.wasted += m_staged.erase(it->first);
+        }
+        m_pending_block = hashBlock;
+        return true;
+    }
+    LOCK(m_write_mutex);
+    if (!WritePendingLocked()) return false;
+    {
+        LOCK(m_mutex);
+        ++m_write_epoch;
+        m_writing = true;
+        m_stats.wasted += m_staged.size();
+        m_staged.clear();
+    }
+    const bool ret{base->BatchWrite(cursor, hashBlock)};
+    LOCK(m_mutex);
+    ++m_write_epoch;
+    m_writing = false;
+    return ret;
+}
+
+bool CCoinsViewPrefetch::WritePending()
+{
+    LOCK(m_write_mutex);
+    return WritePendingLocked();
+}
+
+bool CCoinsViewPrefetch::WritePendingLocked()
+{
+    AssertLockHeld(m_write_mutex);
+    // Copy the coins into a map the base can be handed a cursor for, so that
+    // they can keep being served from m_pending while they are written.
+    CCoinsMapMemoryResource resource;
+    CoinsCachePair sentinel;
+    sentinel.second.SelfRef(sentinel);
+    CCoinsMap coins{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+    std::vector<COutPoint> outpoints;
+    uint64_t seq;
+    uint256 block;
+    {
+        LOCK(m_mutex);
+        if (m_pending.empty()) return true;
+        outpoints.reserve(m_pending.size());
+        for (const auto& [outpoint, pending] : m_pending) {
+            auto [it, _]{coins.try_emplace(outpoint, Coin{pending.coin})};
+            CCoinsCacheEntry::SetDirty(*it, sentinel);
+            outpoints.push_back(outpoint);
+        }
+        seq = m_pending_seq;
+        block = m_pending_block;
+    }
+    CoinsViewCacheCursor cursor{sentinel, coins, outpoints};
+    if (!base->BatchWrite(cursor, block)) return false;
+    LOCK(m_mutex);
+    // Coins written here again in the meantime still have to be written.
+    std::erase_if(m_pending, [&](const auto& item) { return item.second.seq <= seq; });
+    m_last_written.clear();
+    m_last_written.insert(outpoints.begin(), outpoints.end());
+    ++m_pending_writes;
+    return true;
+}
+
+void CCoinsViewPrefetch::Prefetch(std::span<const COutPoint> outpoints)
+{
+    uint64_t epoch;
+    uint64_t pending_writes;
+    {
+        LOCK(m_mutex);
+        m_stats.lookups += outpoints.size();
+        m_stats.wasted += outpoints.size();
+        if (m_writing) return;
+        epoch = m_write_epoch;
+        pending_writes = m_pending_writes;
+    }
+    std::vector<std::optional<Coin>> fetched{base->GetCoins(outpoints)};
+    LOCK(m_mutex);
+    if (m_writing || epoch != m_write_epoch) return;
+    // Lookups that overlapped a single write of pending coins only have to
+    // skip the coins it wrote.
+    if (m_pending_writes - pending_writes > 1) return;
+    const bool overlapped{m_pending_writes != pending_writes};
+    for (size_t i{0}; i < outpoints.size(); ++i) {
+        if (!fetched[i]) continue;
+        if (m_pending.contains(outpoints[i]) || (overlapped && m_last_written.contains(outpoints[i]))) continue;
+        if (m_staged.size() >= MAX_STAGED_COINS) break;
+        // Only lookups that end up staged are not counted as wasted.
+        if (m_staged.try_emplace(outpoints[i], std::move(*fetched[i])).second) --m_stats.wasted;
+    }
+}
+
+void CCoinsViewPrefetch::Clear()
+{
+    LOCK(m_mutex);
+    m_stats.wasted += m_staged.size();
+    m_staged.clear();
+}
+
+size_t CCoinsViewPrefetch::GetStagedCount() const
+{
+    LOCK(m_mutex);
+    return m_staged.size();
+}
+
+size_t CCoinsViewPrefetch::GetPendingCount() const
+{
+    LOCK(m_mutex);
+    return m_pending.size();
+}
+
+CCoinsViewPrefetch::Stats CCoinsViewPrefetch::GetStats() const
+{
+    LOCK(m_mutex);
+    return m_stats;
+}
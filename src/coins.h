@@ -12,6 +12,7 @@
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <support/allocators/pool.h>
+#include <sync.h>
 #include <uint256.h>
 #include <util/check.h>
 #include <util/hasher.h>
@@ -20,7 +21,11 @@
 #include <cstdint>
 
 #include <functional>
+#include <optional>
+#include <span>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -274,15 +279,23 @@ struct CoinsViewCacheCursor
     CoinsViewCacheCursor(CoinsCachePair& sentinel LIFETIMEBOUND,
                          CCoinsMap& map LIFETIMEBOUND,
                          bool will_erase) noexcept
-        : m_sentinel(sentinel), m_map(map), m_will_erase(will_erase) {}
+        : m_sentinel(sentinel), m_map(map), m_will_erase(will_erase), m_begin(sentinel.second.Next()) {}
 
-    inline CoinsCachePair* Begin() const noexcept { return m_sentinel.second.Next(); }
+    //! Only iterate the entries for the given outpoints that are DIRTY but not FRESH, as
+    //! done by CCoinsViewCache::SyncPartial. Entries are erased or unflagged as if will_erase
+    //! was not set. The receiver can tell this case apart with IsPartial().
+    CoinsViewCacheCursor(CoinsCachePair& sentinel LIFETIMEBOUND,
+                         CCoinsMap& map LIFETIMEBOUND,
+                         std::span<const COutPoint> outpoints LIFETIMEBOUND) noexcept
+        : m_sentinel(sentinel), m_map(map), m_will_erase(false), m_partial(true), m_outpoints(outpoints), m_begin(NextPartial()) {}
+
+    inline CoinsCachePair* Begin() const noexcept { return m_begin; }
     inline CoinsCachePair* End() const noexcept { return &m_sentinel; }
 
     //! Return the next entry after current, possibly erasing current
     inline CoinsCachePair* NextAndMaybeErase(CoinsCachePair& current) noexcept
     {
-        const auto next_entry{current.second.Next()};
+        const auto next_entry{m_partial ? nullptr : current.second.Next()};
         // If we are not going to erase the cache, we must still erase spent entries.
         // Otherwise, clear the state of the entry.
         if (!m_will_erase) {
@@ -293,14 +306,37 @@ struct CoinsViewCacheCursor
                 current.second.SetClean();
             }
         }
-        return next_entry;
+        return m_partial ? NextPartial() : next_entry;
     }
 
     inline bool WillErase(CoinsCachePair& current) const noexcept { return m_will_erase || current.second.coin.IsSpent(); }
+    //! Whether only some of the flagged entries are iterated, so that the receiver
+    //! will not be consistent with the cache's best block afterwards.
+    inline bool IsPartial() const noexcept { return m_partial; }
+    //! Number of entries handed out so far in partial mode.
+    inline size_t PartialCount() const noexcept { return m_partial_count; }
 private:
     CoinsCachePair& m_sentinel;
     CCoinsMap& m_map;
     bool m_will_erase;
+    bool m_partial{false};
+    //! Outpoints to iterate in partial mode, and the number of them consumed so far.
+    std::span<const COutPoint> m_outpoints;
+    size_t m_pos{0};
+    size_t m_partial_count{0};
+    CoinsCachePair* m_begin;
+
+    CoinsCachePair* NextPartial() noexcept
+    {
+        while (m_pos < m_outpoints.size()) {
+            const auto it{m_map.find(m_outpoints[m_pos++])};
+            if (it != m_map.end() && it->second.IsDirty() && !it->second.IsFresh()) {
+                ++m_partial_count;
+                return &*it;
+            }
+        }
+        return &m_sentinel;
+    }
 };
 
 /** Abstract view on the open txout dataset. */
@@ -313,6 +349,11 @@ public:
     //! Just check whether a given outpoint is unspent.
     virtual bool HaveCoin(const COutPoint &outpoint) const;
 
+    //! Retrieve the Coins for several outpoints at once, in the order of outpoints.
+    //! Views able to serve bulk lookups more efficiently than one GetCoin() call
+    //! per outpoint should override this.
+    virtual std::vector<std::optional<Coin>> GetCoins(std::span<const COutPoint> outpoints) const;
+
     //! Retrieve the block hash whose state this CCoinsView currently represents
     virtual uint256 GetBestBlock() const;
 
@@ -376,6 +417,14 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage{0};
 
+    /**
+     * Outpoints of entries that became DIRTY without being FRESH, in that
+     * order, for SyncPartial() to write. Entries that are not recorded
+     * because the queue is full are written by the next Flush() or Sync().
+     */
+    std::vector<COutPoint> m_partial_sync_queue;
+    size_t m_max_partial_sync_queue{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn, bool deterministic = false);
 
@@ -401,6 +450,16 @@ public:
      */
     bool HaveCoinInCache(const COutPoint &outpoint) const;
 
+    /**
+     * Look up a coin in this cache only, without calls to the backing
+     * CCoinsView. Unlike HaveCoinInCache(), this tells outpoints cached as
+     * spent apart from ones that are not cached.
+     *
+     * @returns std::nullopt if the outpoint is not cached, or the cached coin,
+     *          which is spent if the outpoint is cached as spent.
+     */
+    std::optional<Coin> PeekCoin(const COutPoint& outpoint) const;
+
     /**
      * Return a reference to Coin in the cache, or coinEmpty if not found. This is
      * more efficient than GetCoin.
@@ -452,6 +511,25 @@ public:
      */
     bool Sync();
 
+    /**
+     * Push up to max_coins modified entries that the base already knows
+     * about (DIRTY but not FRESH) to the base, in the order they were
+     * modified, and clear them like Sync() does. The base is not made
+     * consistent with this cache's best block, which it must be able to
+     * recover from (see CCoinsViewDB::BatchWrite).
+     *
+     * Entries are only tracked for this after EnablePartialSync().
+     * @returns the number of entries pushed, or std::nullopt on failure, in
+     *          which case the state of the backing view is undefined.
+     */
+    std::optional<size_t> SyncPartial(size_t max_coins);
+
+    //! Track up to max_queued entries to be pushed by SyncPartial(). Passing 0 disables tracking.
+    void EnablePartialSync(size_t max_queued);
+
+    //! Number of entries waiting to be pushed by SyncPartial().
+    size_t GetPartialSyncQueueSize() const { return m_partial_sync_queue.size(); }
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -483,6 +561,9 @@ private:
      * memory usage.
      */
     CCoinsMap::iterator FetchCoin(const COutPoint &outpoint) const;
+
+    //! Record an entry that just became DIRTY without being FRESH for SyncPartial().
+    void QueuePartialSync(const COutPoint& outpoint);
 };
 
 //! Utility function to add all of a transaction's outputs to a cache.
@@ -517,6 +598,7 @@ public:
 
     std::optional<Coin> GetCoin(const COutPoint& outpoint) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
+    std::vector<std::optional<Coin>> GetCoins(std::span<const COutPoint> outpoints) const override;
 
 private:
     /** A list of callbacks to execute upon leveldb read error. */
@@ -524,4 +606,91 @@ private:
 
 };
 
+/**
+ * CCoinsView layer used to warm the coins cache from background threads.
+ * Coins that a block about to be connected will spend are looked up in the
+ * backing view ahead of time and staged here, so that the cache sitting on top
+ * of this view finds them in memory on a miss.
+ *
+ * Staged coins are handed out at most once, and the whole staging area is
+ * dropped whenever the cache above writes all its changes through this view.
+ * Lookups that overlap such a write are discarded instead of staged, so a coin
+ * read before a flush is never served after the flush has changed the backing
+ * view.
+ *
+ * Partial writes (see CCoinsViewCache::SyncPartial) are not passed on right
+ * away. Their coins are held here, and served in place of the backing view,
+ * until WritePending() writes them, which does not need the cache above to be
+ * locked. Only the staged coins that such a write overwrites are dropped.
+ *
+ * Prefetch() may be called from any thread, provided the backing view
+ * supports concurrent reads (as CCoinsViewDB does).
+ */
+class CCoinsViewPrefetch final : public CCoinsViewBacked
+{
+public:
+    //! Upper bound on the number of staged coins.
+    static constexpr size_t MAX_STAGED_COINS{1 << 17};
+
+    struct Stats {
+        //! Outpoints looked up in the backing view by Prefetch().
+        uint64_t lookups{0};
+        //! Staged coins that were handed out to the view above.
+        uint64_t hits{0};
+        //! Lookups that did not result in a staged coin (not found, or raced
+        //! a write), plus staged coins that were dropped without being used.
+        uint64_t wasted{0};
+    };
+
+    explicit CCoinsViewPrefetch(CCoinsView* view) : CCoinsViewBacked(view) {}
+
+    std::optional<Coin> GetCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool HaveCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool BatchWrite(CoinsViewCacheCursor& cursor, const uint256& hashBlock) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex, !m_write_mutex);
+
+    //! Look up the given outpoints in the backing view and stage the unspent ones.
+    void Prefetch(std::span<const COutPoint> outpoints) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Write the coins held back from partial writes to the backing view, as a
+     * partial write for the latest block they were written for.
+     * @returns false on failure, in which case the state of the backing view
+     *          is undefined.
+     */
+    bool WritePending() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex, !m_write_mutex);
+
+    //! Drop all staged coins. Coins waiting for WritePending() are kept.
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    size_t GetStagedCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t GetPendingCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    Stats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct PendingCoin {
+        //! Spent for coins to be erased from the backing view.
+        Coin coin;
+        //! Value of m_pending_seq when the coin was last written here.
+        uint64_t seq;
+    };
+
+    //! Held while writing to the backing view, so that writes reach it in order.
+    Mutex m_write_mutex ACQUIRED_BEFORE(m_mutex);
+    mutable Mutex m_mutex;
+    mutable std::unordered_map<COutPoint, Coin, SaltedOutpointHasher> m_staged GUARDED_BY(m_mutex);
+    std::unordered_map<COutPoint, PendingCoin, SaltedOutpointHasher> m_pending GUARDED_BY(m_mutex);
+    uint64_t m_pending_seq GUARDED_BY(m_mutex){0};
+    uint256 m_pending_block GUARDED_BY(m_mutex);
+    //! Outpoints written by the last WritePending() call, and the number of
+    //! calls that wrote anything, for lookups that overlapped them to skip.
+    std::unordered_set<COutPoint, SaltedOutpointHasher> m_last_written GUARDED_BY(m_mutex);
+    uint64_t m_pending_writes GUARDED_BY(m_mutex){0};
+    //! Incremented at the start and end of every write of a whole batch.
+    uint64_t m_write_epoch GUARDED_BY(m_mutex){0};
+    bool m_writing GUARDED_BY(m_mutex){false};
+    mutable Stats m_stats GUARDED_BY(m_mutex);
+
+    bool WritePendingLocked() EXCLUSIVE_LOCKS_REQUIRED(m_write_mutex, !m_mutex);
+};
+
 #endif // BITCOIN_COINS_H
@@ -10,6 +10,10 @@
 #include <string>
 #include <tuple>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace {
 
 using ByteAsHex = std::array<char, 2>;
@@ -35,8 +39,31 @@ std::string HexStr(const std::span<const uint8_t> s)
     static_assert(sizeof(byte_to_hex) == 512);
 
     char* it = rv.data();
-    for (uint8_t v : s) {
-        std::memcpy(it, byte_to_hex[v].data(), 2);
+    size_t i = 0;
+#if defined(__SSE2__)
+    // SSE2 is part of the x86-64 baseline, so this needs no runtime check.
+    // Turn 16 bytes into 32 nibbles, high nibble first, and map 0-9 and
+    // 10-15 to '0'-'9' and 'a'-'f' by adding '0' and, for the latter, the
+    // distance from '9' + 1 to 'a'.
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i letter_offset = _mm_set1_epi8('a' - '9' - 1);
+    const auto to_hex = [&](__m128i nibbles) {
+        const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, nine), letter_offset);
+        return _mm_add_epi8(_mm_add_epi8(nibbles, zero_char), letters);
+    };
+    for (; s.size() - i >= 16; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.data() + i));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble);
+        const __m128i low = _mm_and_si128(bytes, low_nibble);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(it), to_hex(_mm_unpacklo_epi8(high, low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(it + 16), to_hex(_mm_unpackhi_epi8(high, low)));
+        it += 32;
+    }
+#endif
+    for (; i < s.size(); ++i) {
+        std::memcpy(it, byte_to_hex[s[i]].data(), 2);
         it += 2;
     }
 
@@ -13,12 +13,17 @@
 #include <util/fs_helpers.h>
 #include <util/obfuscation.h>
 #include <util/strencodings.h>
+#include <util/threadpool.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <exception>
+#include <functional>
+#include <future>
 #include <leveldb/cache.h>
 #include <leveldb/db.h>
 #include <leveldb/env.h>
@@ -30,8 +35,10 @@
 #include <leveldb/status.h>
 #include <leveldb/write_batch.h>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <utility>
+#include <vector>
 
 static auto CharCast(const std::byte* data) { return reinterpret_cast<const char*>(data); }
 
@@ -315,6 +322,100 @@ std::optional<std::string> CDBWrapper::ReadImpl(std::span<const std::byte> key)
     return strValue;
 }
 
+struct CDBSnapshot::SnapshotImpl {
+    leveldb::DB& db;
+    const leveldb::Snapshot* const snapshot;
+
+    explicit SnapshotImpl(leveldb::DB& _db) : db{_db}, snapshot{_db.GetSnapshot()} {}
+    ~SnapshotImpl() { db.ReleaseSnapshot(snapshot); }
+};
+
+CDBSnapshot::CDBSnapshot(std::unique_ptr<SnapshotImpl> impl) : m_impl_snapshot{std::move(impl)} {}
+
+CDBSnapshot::~CDBSnapshot() = default;
+
+std::unique_ptr<CDBSnapshot> CDBWrapper::GetSnapshot() const
+{
+    return std::make_unique<CDBSnapshot>(std::make_unique<CDBSnapshot::SnapshotImpl>(*DBContext().pdb));
+}
+
+std::vector<std::optional<std::string>> CDBWrapper::ReadManyImpl(std::span<const std::span<const std::byte>> keys, ThreadPool* pool, const CDBSnapshot* snapshot) const
+{
+    std::vector<std::optional<std::string>> values(keys.size());
+
+    // Visit the keys in the order of leveldb's default bytewise comparator.
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::lexicographical_compare(keys[a].begin(), keys[a].end(), keys[b].begin(), keys[b].end());
+    });
+
+    std::unique_ptr<CDBSnapshot> own_snapshot;
+    if (!snapshot) {
+        own_snapshot = GetSnapshot();
+        snapshot = own_snapshot.get();
+    }
+    leveldb::DB& db{*DBContext().pdb};
+    leveldb::ReadOptions options{DBContext().readoptions};
+    options.snapshot = snapshot->m_impl_snapshot->snapshot;
+
+    const auto read_range{[&](size_t begin, size_t end) {
+        std::string strValue;
+        for (size_t i{begin}; i < end; ++i) {
+            const auto& key{keys[order[i]]};
+            leveldb::Status status = db.Get(options, leveldb::Slice(CharCast(key.data()), key.size()), &strValue);
+            if (!status.ok()) {
+                if (status.IsNotFound()) continue;
+                LogPrintf("LevelDB read failure: %s\n", status.ToString());
+                HandleError(status);
+            }
+            values[order[i]] = std::move(strValue);
+        }
+    }};
+
+    const size_t readers{pool ? std::min(pool->WorkersCount(), keys.size() / DBWRAPPER_MIN_KEYS_PER_READER) : 0};
+    if (readers < 2) {
+        read_range(0, keys.size());
+        return values;
+    }
+    // Hand each reader a contiguous range of the sorted keys. The calling
+    // thread reads the ranges no worker has picked up yet itself, and only
+    // waits for ranges being read, so that this is also safe to call from a
+    // worker of the pool.
+    const auto taken{std::make_shared<std::vector<std::atomic<bool>>>(readers)};
+    const auto read_reader_range{[&](size_t r) { read_range(keys.size() * r / readers, keys.size() * (r + 1) / readers); }};
+    std::vector<std::future<void>> futures;
+    futures.reserve(readers);
+    for (size_t r{0}; r < readers; ++r) {
+        // A task that finds its range taken must not touch the local state
+        // captured by reference, which may be gone by then.
+        futures.emplace_back(pool->Submit([&, taken, r] {
+            if (!(*taken)[r].exchange(true)) read_reader_range(r);
+        }));
+    }
+    std::vector<bool> read_here(readers, false);
+    std::exception_ptr error;
+    for (size_t r{0}; r < readers; ++r) {
+        if ((*taken)[r].exchange(true)) continue;
+        read_here[r] = true;
+        if (error) continue;
+        try {
+            read_reader_range(r);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    // Wait for all readers before rethrowing, as they reference local state.
+    for (size_t r{0}; r < readers; ++r) {
+        if (!read_here[r]) futures[r].wait();
+    }
+    if (error) std::rethrow_exception(error);
+    for (size_t r{0}; r < readers; ++r) {
+        if (!read_here[r]) futures[r].get();
+    }
+    return values;
+}
+
 bool CDBWrapper::ExistsImpl(std::span<const std::byte> key) const
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
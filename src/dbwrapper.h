@@ -18,10 +18,15 @@
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+class ThreadPool;
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 static const size_t DBWRAPPER_MAX_FILE_SIZE = 32 << 20; // 32 MiB
+//! Minimum number of keys handed to each worker thread by CDBWrapper::ReadMany.
+static const size_t DBWRAPPER_MIN_KEYS_PER_READER = 64;
 
 //! User-controlled performance and debug options.
 struct DBOptions {
@@ -173,6 +178,25 @@ public:
     }
 };
 
+/**
+ * A consistent read-only view of a CDBWrapper, as of when it was taken with
+ * CDBWrapper::GetSnapshot(). Writes made afterwards are not visible through it.
+ * Must not outlive the CDBWrapper it was taken from.
+ */
+class CDBSnapshot
+{
+public:
+    struct SnapshotImpl;
+
+private:
+    const std::unique_ptr<SnapshotImpl> m_impl_snapshot;
+    friend class CDBWrapper;
+
+public:
+    explicit CDBSnapshot(std::unique_ptr<SnapshotImpl> impl);
+    ~CDBSnapshot();
+};
+
 struct LevelDBContext;
 
 class CDBWrapper
@@ -198,6 +222,7 @@ private:
     bool m_is_memory;
 
     std::optional<std::string> ReadImpl(std::span<const std::byte> key) const;
+    std::vector<std::optional<std::string>> ReadManyImpl(std::span<const std::span<const std::byte>> keys, ThreadPool* pool, const CDBSnapshot* snapshot) const;
     bool ExistsImpl(std::span<const std::byte> key) const;
     size_t EstimateSizeImpl(std::span<const std::byte> key1, std::span<const std::byte> key2) const;
     auto& DBContext() const LIFETIMEBOUND { return *Assert(m_db_context); }
@@ -229,6 +254,43 @@ public:
         return true;
     }
 
+    /**
+     * Read the values stored under several keys from a single consistent
+     * snapshot of the database, which is taken now unless one is given.
+     * Lookups are done in key order to benefit from locality in the
+     * underlying tables, and are spread over the workers of pool if one is
+     * given. The calling thread reads what the workers have not picked up,
+     * so it may be one of those workers.
+     *
+     * @returns one entry per key, in the order of keys, holding std::nullopt
+     *          if the key was not found or its value failed to deserialize.
+     */
+    template <typename V, typename K>
+    std::vector<std::optional<V>> ReadMany(std::span<const K> keys, ThreadPool* pool = nullptr, const CDBSnapshot* snapshot = nullptr) const
+    {
+        std::vector<DataStream> key_streams(keys.size());
+        std::vector<std::span<const std::byte>> key_spans;
+        key_spans.reserve(keys.size());
+        for (size_t i{0}; i < keys.size(); ++i) {
+            key_streams[i].reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+            key_streams[i] << keys[i];
+            key_spans.emplace_back(key_streams[i]);
+        }
+        std::vector<std::optional<std::string>> str_values{ReadManyImpl(key_spans, pool, snapshot)};
+        std::vector<std::optional<V>> values(keys.size());
+        for (size_t i{0}; i < keys.size(); ++i) {
+            if (!str_values[i]) continue;
+            try {
+                DataStream ssValue{MakeByteSpan(*str_values[i])};
+                m_obfuscation(ssValue);
+                ssValue >> values[i].emplace();
+            } catch (const std::exception&) {
+                values[i].reset();
+            }
+        }
+        return values;
+    }
+
     template <typename K, typename V>
     void Write(const K& key, const V& value, bool fSync = false)
     {
@@ -269,6 +331,9 @@ public:
 
     CDBIterator* NewIterator();
 
+    //! Take a snapshot of the database to read from later with ReadMany().
+    std::unique_ptr<CDBSnapshot> GetSnapshot() const;
+
     /**
      * Return true if the database managed by this class contains no entries.
      */
@@ -9,6 +9,7 @@
 #include <httpserver.h>
 #include <logging.h>
 #include <netaddress.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/fs.h>
@@ -24,6 +25,7 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using util::SplitString;
@@ -162,7 +164,37 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
             // 2.0 behavior is to catch exceptions and return HTTP success with
             // RPC errors, as long as there is not an actual HTTP server error.
             const bool catch_errors{jreq.m_json_version == JSONRPCVersion::V2};
-            reply = JSONRPCExec(jreq, catch_errors);
+
+            // Let methods that support it stream their result into a chunked
+            // reply. The reply is only started once the first chunk of output
+            // is ready, so that errors raised before that can still be sent
+            // as usual.
+            std::optional<JSONStreamWriter> stream;
+            size_t stream_prefix_size{0};
+            if (!jreq.IsNotification()) {
+                stream.emplace([&](std::string_view chunk) {
+                    if (!stream->Flushed()) {
+                        req->WriteHeader("Content-Type", "application/json");
+                        req->StartReply(HTTP_OK);
+                    }
+                    req->WriteReplyChunk(chunk);
+                });
+                stream->BeginObject();
+                if (jreq.m_json_version == JSONRPCVersion::V2) stream->KeyValue("jsonrpc", "2.0");
+                stream->Key("result");
+                stream_prefix_size = stream->BytesWritten();
+                jreq.m_result_stream = &*stream;
+            }
+            try {
+                reply = JSONRPCExec(jreq, catch_errors);
+            } catch (...) {
+                if (stream && stream->Flushed()) {
+                    LogPrintf("RPC call %s failed after part of its result was sent\n", jreq.strMethod);
+                    req->EndReply();
+                    return false;
+                }
+                throw;
+            }
 
             if (jreq.IsNotification()) {
                 // Even though we do execute notifications, we do not respond to them
@@ -170,6 +202,22 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                 return true;
             }
 
+            if (stream && stream->BytesWritten() > stream_prefix_size) {
+                if (reply.find_value("error").isNull()) {
+                    if (jreq.m_json_version == JSONRPCVersion::V1_LEGACY) stream->KeyValue("error", NullUniValue);
+                    if (jreq.id.has_value()) stream->KeyValue("id", *jreq.id);
+                    stream->EndObject();
+                    stream->Flush();
+                    req->WriteReplyChunk("\n");
+                    req->EndReply();
+                    return true;
+                } else if (stream->Flushed()) {
+                    LogPrintf("RPC call %s failed after part of its result was sent\n", jreq.strMethod);
+                    req->EndReply();
+                    return false;
+                }
+            }
+
         // array of requests
         } else if (valRequest.isArray()) {
             // Check authorization for each request's method
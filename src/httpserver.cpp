@@ -19,6 +19,7 @@
 #include <util/threadnames.h>
 #include <util/translation.h>
 
+#include <algorithm>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
@@ -69,52 +70,93 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Work queue for distributing work over multiple threads, fairly between clients.
+ * Work items are simply callable objects. Each client has its own FIFO queue,
+ * and workers serve the clients with queued work in round-robin order. A
+ * client may have at most maxRunning items running at once, so that the slow
+ * requests of one client cannot occupy all workers while the requests of
+ * other clients wait behind them.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
+    struct ClientQueue {
+        std::deque<std::unique_ptr<WorkItem>> items;
+        size_t running{0};
+    };
+
     Mutex cs;
     std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
+    //! Queued and running work of each client
+    std::unordered_map<std::string, ClientQueue> clients GUARDED_BY(cs);
+    //! Clients with queued work, in the order they are served
+    std::deque<std::string> ready GUARDED_BY(cs);
+    size_t depth GUARDED_BY(cs){0};
     bool running GUARDED_BY(cs){true};
     const size_t maxDepth;
+    const size_t maxRunning;
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : maxDepth(_maxDepth)
+    explicit WorkQueue(size_t _maxDepth, size_t _maxRunning) : maxDepth(_maxDepth), maxRunning(_maxRunning)
     {
     }
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue() = default;
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    /** Enqueue a work item on behalf of client */
+    bool Enqueue(const std::string& client, WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
         LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
+        if (!running || depth >= maxDepth) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        ClientQueue& queue{clients[client]};
+        if (queue.items.empty()) ready.push_back(client);
+        queue.items.emplace_back(std::unique_ptr<WorkItem>(item));
+        ++depth;
         cond.notify_one();
         return true;
     }
     /** Thread function */
     void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
+        WAIT_LOCK(cs, lock);
         while (true) {
-            std::unique_ptr<WorkItem> i;
+            // Serve the first client in line that is below its running limit.
+            auto next{ready.end()};
+            cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(cs) {
+                next = std::find_if(ready.begin(), ready.end(), [&](const std::string& client) EXCLUSIVE_LOCKS_REQUIRED(cs) {
+                    return clients.at(client).running < maxRunning;
+                });
+                return next != ready.end() || (!running && ready.empty());
+            });
+            if (next == ready.end())
+                break;
+            const std::string client{std::move(*next)};
+            ready.erase(next);
+            ClientQueue& queue{clients.at(client)};
+            std::unique_ptr<WorkItem> i{std::move(queue.items.front())};
+            queue.items.pop_front();
+            if (!queue.items.empty()) ready.push_back(client);
+            --depth;
+            ++queue.running;
             {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running && queue.empty())
-                    break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                REVERSE_LOCK(lock, cs);
+                (*i)();
+                i.reset();
+            }
+            if (--queue.running == 0 && queue.items.empty()) {
+                clients.erase(client);
+            }
+            // Work of this client may have been held back by its running
+            // limit. Once interrupted, wake everyone so that idle workers
+            // notice when the last work is done.
+            if (!running) {
+                cond.notify_all();
+            } else if (!ready.empty()) {
+                cond.notify_one();
             }
-            (*i)();
         }
     }
     /** Interrupt and exit loops */
@@ -260,6 +302,12 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m)
     assert(false);
 }
 
+/** Identify the client a request is scheduled for, by its network address and credentials */
+static std::string RequestClient(const HTTPRequest& req)
+{
+    return strprintf("%s %s", req.GetPeer().ToStringAddr(), req.GetHeader("Authorization").second);
+}
+
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request* req, void* arg)
 {
@@ -329,7 +377,7 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
     if (i != iend) {
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
+        if (g_work_queue->Enqueue(RequestClient(*item->req), item.get())) {
             item.release(); /* if true, queue took ownership */
         } else {
             LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
@@ -478,9 +526,12 @@ bool InitHTTPServer(const util::SignalInterrupt& interrupt)
 
     LogDebug(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogDebug(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
+    int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    int maxRunningPerClient = gArgs.GetIntArg("-rpcclientthreads", 0);
+    if (maxRunningPerClient <= 0 || maxRunningPerClient > rpcThreads) maxRunningPerClient = rpcThreads;
+    LogDebug(BCLog::HTTP, "creating work queue of depth %d, running up to %d requests per client\n", workQueueDepth, maxRunningPerClient);
 
-    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth, maxRunningPerClient);
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -604,6 +655,9 @@ HTTPRequest::~HTTPRequest()
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
+    } else if (m_chunked) {
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        EndReply();
     }
     // evhttpd cleans up the request, as long as a reply was sent.
 }
@@ -646,6 +700,22 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/** Re-enable reading from the socket once a reply was sent. This is the second
+ * part of the libevent workaround in http_request_cb.
+ */
+static void ReenableReading(evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02010900) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -664,20 +734,57 @@ void HTTPRequest::WriteReply(int nStatus, std::span<const std::byte> reply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02010900) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
-        }
+        ReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** Like WriteReply, the parts of a chunked reply are sent from the main http
+ * thread. The events are triggered in order, so the chunks are sent in the
+ * order they were written.
+ */
+void HTTPRequest::StartReply(int nStatus)
+{
+    assert(!replySent && req);
+    if (m_interrupt) {
+        WriteHeader("Connection", "close");
+    }
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
     });
     ev->trigger(nullptr);
     replySent = true;
+    m_chunked = true;
+}
+
+void HTTPRequest::WriteReplyChunk(std::span<const std::byte> chunk)
+{
+    assert(m_chunked && req);
+    if (chunk.empty()) return; // an empty chunk would end the reply
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, chunk.data(), chunk.size());
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb]{
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndReply()
+{
+    assert(m_chunked && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy]{
+        evhttp_send_reply_end(req_copy);
+        ReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    m_chunked = false;
     req = nullptr; // transferred back to main thread
 }
 
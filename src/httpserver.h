@@ -73,6 +73,8 @@ private:
     struct evhttp_request* req;
     const util::SignalInterrupt& m_interrupt;
     bool replySent;
+    //! Whether a chunked reply was started and is yet to be ended
+    bool m_chunked{false};
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, const util::SignalInterrupt& interrupt, bool replySent = false);
@@ -143,6 +145,25 @@ public:
         WriteReply(nStatus, std::as_bytes(std::span{reply}));
     }
     void WriteReply(int nStatus, std::span<const std::byte> reply);
+
+    /**
+     * Start a chunked HTTP reply, for replies whose body is produced piece
+     * by piece. Send the body with WriteReplyChunk and finish it with
+     * EndReply. nStatus is the HTTP status code to send.
+     *
+     * @note Can be called only once, instead of WriteReply. Do not call any
+     * other HTTPRequest methods than WriteReplyChunk and EndReply after
+     * calling this.
+     */
+    void StartReply(int nStatus);
+    /** Send the next part of the body of a reply started with StartReply. */
+    void WriteReplyChunk(std::string_view chunk)
+    {
+        WriteReplyChunk(std::as_bytes(std::span{chunk}));
+    }
+    void WriteReplyChunk(std::span<const std::byte> chunk);
+    /** Finish a reply started with StartReply, giving the request back to the main thread. */
+    void EndReply();
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -0,0 +1,271 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addrindex.h>
+
+#include <coins.h>
+#include <common/args.h>
+#include <compressor.h>
+#include <crypto/sha256.h>
+#include <dbwrapper.h>
+#include <index/base.h>
+#include <interfaces/chain.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <uint256.h>
+#include <undo.h>
+#include <util/check.h>
+#include <util/fs.h>
+
+#include <any>
+#include <cassert>
+#include <ios>
+#include <map>
+#include <span>
+#include <utility>
+
+static constexpr uint8_t DB_ADDRINDEX{'a'};
+
+std::unique_ptr<AddrIndex> g_addr_index;
+
+namespace {
+
+struct DBKey {
+    uint256 script_hash;
+    int height{0};
+    uint32_t tx_pos{0};
+    bool spending{false};
+    uint32_t index{0};
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRINDEX);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, tx_pos);
+        ser_writedata8(s, spending);
+        ser_writedata32be(s, index);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_ADDRINDEX) {
+            throw std::ios_base::failure("Invalid format for address index DB key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        tx_pos = ser_readdata32be(s);
+        spending = ser_readdata8(s);
+        index = ser_readdata32be(s);
+    }
+};
+
+struct DBVal {
+    Txid txid;
+    CAmount amount{0};
+    bool spent{false};
+
+    SERIALIZE_METHODS(DBVal, obj)
+    {
+        READWRITE(obj.txid, Using<AmountCompression>(obj.amount), obj.spent);
+    }
+};
+
+/** An output spent by a block, which was created in an earlier block. */
+struct Spend {
+    uint256 script_hash;
+    int height;
+    COutPoint prevout;
+};
+
+/** The entries a block adds to the index. */
+struct BlockEntries {
+    std::vector<std::pair<DBKey, DBVal>> entries;
+    std::vector<Spend> spends;
+};
+
+} // namespace
+
+/** Access to the address index database (indexes/addrindex/) */
+class AddrIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Find the entry of an output created at a height and paying to a script.
+    std::optional<std::pair<DBKey, DBVal>> FindOutput(const uint256& script_hash, int height, const COutPoint& outpoint);
+};
+
+AddrIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "addrindex", n_cache_size, f_memory, f_wipe)
+{}
+
+std::optional<std::pair<DBKey, DBVal>> AddrIndex::DB::FindOutput(const uint256& script_hash, int height, const COutPoint& outpoint)
+{
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+    DBKey key{.script_hash = script_hash, .height = height};
+    for (db_it->Seek(key); db_it->Valid(); db_it->Next()) {
+        if (!db_it->GetKey(key) || key.script_hash != script_hash || key.height != height) break;
+        if (key.spending || key.index != outpoint.n) continue;
+        DBVal value;
+        if (!db_it->GetValue(value)) {
+            LogError("unable to read value in address index for script hash %s", script_hash.ToString());
+            return std::nullopt;
+        }
+        if (value.txid == outpoint.hash) return std::make_pair(key, value);
+    }
+    return std::nullopt;
+}
+
+AddrIndex::AddrIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "addrindex"), m_db(std::make_unique<AddrIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddrIndex::~AddrIndex() = default;
+
+uint256 AddrIndex::ScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+interfaces::Chain::NotifyOptions AddrIndex::CustomOptions()
+{
+    interfaces::Chain::NotifyOptions options;
+    options.connect_undo_data = true;
+    options.disconnect_data = true;
+    options.disconnect_undo_data = true;
+    return options;
+}
+
+/** Compute the entries of a block. Outputs spent in the same block are marked spent right away. */
+static BlockEntries GetBlockEntries(const interfaces::BlockInfo& block)
+{
+    BlockEntries result;
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return result;
+
+    assert(block.data);
+    assert(block.undo_data);
+    //! Position in result.entries of the outputs created in this block.
+    std::map<COutPoint, size_t> block_outputs;
+    for (uint32_t tx_pos = 0; tx_pos < block.data->vtx.size(); ++tx_pos) {
+        const CTransaction& tx{*block.data->vtx[tx_pos]};
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo{block.undo_data->vtxundo.at(tx_pos - 1)};
+            for (uint32_t i = 0; i < tx.vin.size(); ++i) {
+                const COutPoint& prevout{tx.vin[i].prevout};
+                const Coin& coin{tx_undo.vprevout.at(i)};
+                const uint256 script_hash{AddrIndex::ScriptHash(coin.out.scriptPubKey)};
+                result.entries.emplace_back(DBKey{script_hash, block.height, tx_pos, /*spending=*/true, i},
+                                            DBVal{tx.GetHash(), coin.out.nValue, /*spent=*/false});
+                if (const auto it{block_outputs.find(prevout)}; it != block_outputs.end()) {
+                    result.entries[it->second].second.spent = true;
+                } else {
+                    result.spends.push_back(Spend{script_hash, int(coin.nHeight), prevout});
+                }
+            }
+        }
+        for (uint32_t i = 0; i < tx.vout.size(); ++i) {
+            const CTxOut& out{tx.vout[i]};
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            block_outputs.emplace(COutPoint{tx.GetHash(), i}, result.entries.size());
+            result.entries.emplace_back(DBKey{AddrIndex::ScriptHash(out.scriptPubKey), block.height, tx_pos, /*spending=*/false, i},
+                                        DBVal{tx.GetHash(), out.nValue, /*spent=*/false});
+        }
+    }
+    return result;
+}
+
+bool AddrIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    return CustomAppendPrepared(block, GetBlockEntries(block));
+}
+
+std::optional<std::any> AddrIndex::CustomPrepare(const interfaces::BlockInfo& block) const
+{
+    return GetBlockEntries(block);
+}
+
+bool AddrIndex::CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared)
+{
+    const auto block_entries{std::any_cast<BlockEntries>(std::move(prepared))};
+    if (block_entries.entries.empty()) return true;
+
+    CDBBatch batch(*m_db);
+    for (const auto& [key, value] : block_entries.entries) {
+        batch.Write(key, value);
+    }
+    for (const Spend& spend : block_entries.spends) {
+        auto output{m_db->FindOutput(spend.script_hash, spend.height, spend.prevout)};
+        if (!output) {
+            LogError("%s: output %s spent in block %s not found", GetName(), spend.prevout.ToString(), block.hash.ToString());
+            return false;
+        }
+        output->second.spent = true;
+        batch.Write(output->first, output->second);
+    }
+    m_db->WriteBatch(batch);
+    return true;
+}
+
+bool AddrIndex::CustomRemove(const interfaces::BlockInfo& block)
+{
+    const BlockEntries block_entries{GetBlockEntries(block)};
+    if (block_entries.entries.empty()) return true;
+
+    CDBBatch batch(*m_db);
+    for (const auto& entry : block_entries.entries) {
+        batch.Erase(entry.first);
+    }
+    for (const Spend& spend : block_entries.spends) {
+        auto output{m_db->FindOutput(spend.script_hash, spend.height, spend.prevout)};
+        if (!output) {
+            LogError("%s: output %s spent in block %s not found", GetName(), spend.prevout.ToString(), block.hash.ToString());
+            return false;
+        }
+        output->second.spent = false;
+        batch.Write(output->first, output->second);
+    }
+    m_db->WriteBatch(batch);
+    return true;
+}
+
+BaseIndex::DB& AddrIndex::GetDB() const { return *m_db; }
+
+std::optional<std::vector<AddrIndexEntry>> AddrIndex::FindScriptHistory(const uint256& script_hash, size_t skip, size_t count) const
+{
+    std::vector<AddrIndexEntry> result;
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBKey key{.script_hash = script_hash};
+    for (db_it->Seek(key); db_it->Valid() && result.size() < count; db_it->Next()) {
+        if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+        if (skip > 0) {
+            --skip;
+            continue;
+        }
+        DBVal value;
+        if (!db_it->GetValue(value)) {
+            LogError("unable to read value in %s for script hash %s", GetName(), script_hash.ToString());
+            return std::nullopt;
+        }
+        result.push_back(AddrIndexEntry{
+            .height = key.height,
+            .tx_pos = key.tx_pos,
+            .txid = value.txid,
+            .spending = key.spending,
+            .index = key.index,
+            .amount = value.amount,
+            .spent = value.spent,
+        });
+    }
+    return result;
+}
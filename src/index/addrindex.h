@@ -0,0 +1,97 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRINDEX_H
+#define BITCOIN_INDEX_ADDRINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <interfaces/chain.h>
+#include <primitives/transaction_identifier.h>
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class CScript;
+
+static constexpr bool DEFAULT_ADDRINDEX{false};
+
+/** A transaction paying to or spending from a script, as recorded by AddrIndex. */
+struct AddrIndexEntry {
+    //! Height of the block containing the transaction.
+    int height;
+    //! Position of the transaction in the block.
+    uint32_t tx_pos;
+    Txid txid;
+    //! Whether this is an input spending from the script, rather than an output paying to it.
+    bool spending;
+    //! Index of the input or output in the transaction.
+    uint32_t index;
+    CAmount amount;
+    //! For outputs, whether the output is spent in the chain the index is synced to.
+    bool spent;
+};
+
+/**
+ * AddrIndex records, for every script, the transactions in the blockchain
+ * that pay to it or spend from it.
+ *
+ * Entries are keyed by the SHA256 hash of the script (the Electrum "script
+ * hash"), followed by the block height, the position of the transaction in
+ * the block and the input or output index, so that the history of a script
+ * is a single contiguous range of the database in chain order. Outputs
+ * carry a flag that is set once they are spent.
+ */
+class AddrIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    interfaces::Chain::NotifyOptions CustomOptions() override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool AllowParallelSync() const override { return true; }
+
+    std::optional<std::any> CustomPrepare(const interfaces::BlockInfo& block) const override;
+
+    bool CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared) override;
+
+    bool CustomRemove(const interfaces::BlockInfo& block) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddrIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddrIndex() override;
+
+    /// The hash a script is indexed by.
+    static uint256 ScriptHash(const CScript& script);
+
+    /// Look up the history of a script, in chain order.
+    ///
+    /// @param[in]   script_hash  The hash of the script, see ScriptHash().
+    /// @param[in]   skip  The number of entries to skip.
+    /// @param[in]   count  The maximum number of entries to return.
+    /// @return  The entries, or std::nullopt if the database could not be read.
+    std::optional<std::vector<AddrIndexEntry>> FindScriptHistory(const uint256& script_hash, size_t skip, size_t count) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddrIndex> g_addr_index;
+
+#endif // BITCOIN_INDEX_ADDRINDEX_H
@@ -7,6 +7,7 @@
 #include <chain.h>
 #include <common/args.h>
 #include <dbwrapper.h>
+#include <index/blockreader.h>
 #include <interfaces/chain.h>
 #include <interfaces/types.h>
 #include <kernel/chain.h>
@@ -30,9 +31,13 @@
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <algorithm>
+#include <any>
 #include <cassert>
 #include <compare>
+#include <condition_variable>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <optional>
 #include <span>
@@ -163,22 +168,31 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain&
     return chain.Next(chain.FindFork(pindex_prev));
 }
 
+std::optional<IndexBlockData> BaseIndex::ReadBlockData(const CBlockIndex& block_index, bool undo)
+{
+    if (m_block_reader) return m_block_reader->Read(*this, block_index, undo, m_interrupt);
+    return ReadIndexBlockData(m_chainstate->m_blockman, block_index, undo);
+}
+
 bool BaseIndex::ProcessBlock(const CBlockIndex* pindex, const CBlock* block_data)
 {
     interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex, block_data);
 
-    CBlock block;
+    std::optional<IndexBlockData> read_data;
+    CBlockUndo block_undo;
     if (!block_data) { // disk lookup if block data wasn't provided
-        if (!m_chainstate->m_blockman.ReadBlock(block, *pindex)) {
-            FatalErrorf("Failed to read block %s from disk",
-                        pindex->GetBlockHash().ToString());
+        read_data = ReadBlockData(*pindex, CustomOptions().connect_undo_data);
+        if (!read_data) {
+            // Reads through m_block_reader are cut short when interrupted.
+            if (!m_interrupt) {
+                FatalErrorf("Failed to read block %s from disk",
+                            pindex->GetBlockHash().ToString());
+            }
             return false;
         }
-        block_info.data = &block;
-    }
-
-    CBlockUndo block_undo;
-    if (CustomOptions().connect_undo_data) {
+        block_info.data = read_data->block.get();
+        block_info.undo_data = read_data->undo.get();
+    } else if (CustomOptions().connect_undo_data) {
         if (pindex->nHeight > 0 && !m_chainstate->m_blockman.ReadBlockUndo(block_undo, *pindex)) {
             FatalErrorf("Failed to read undo block data %s from disk",
                         pindex->GetBlockHash().ToString());
@@ -196,10 +210,115 @@ bool BaseIndex::ProcessBlock(const CBlockIndex* pindex, const CBlock* block_data
     return true;
 }
 
+std::optional<std::any> BaseIndex::PrepareBlock(const CBlockIndex& block_index)
+{
+    const std::optional<IndexBlockData> read_data{ReadBlockData(block_index, CustomOptions().connect_undo_data)};
+    if (!read_data) return std::nullopt;
+
+    interfaces::BlockInfo block_info = kernel::MakeBlockInfo(&block_index, read_data->block.get());
+    block_info.undo_data = read_data->undo.get();
+    return CustomPrepare(block_info);
+}
+
+bool BaseIndex::ProcessPreparedBlock(const CBlockIndex* pindex, std::any prepared)
+{
+    if (!CustomAppendPrepared(kernel::MakeBlockInfo(pindex), std::move(prepared))) {
+        FatalErrorf("Failed to write block %s to index database",
+                    pindex->GetBlockHash().ToString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Worker threads reading and preparing the blocks of the active chain ahead of
+ * the sync thread, which takes the results in chain order. Workers stay at
+ * most a fixed window of blocks ahead, which bounds the memory used for
+ * results that cannot be appended yet.
+ */
+class BaseIndex::SyncPipeline
+{
+public:
+    struct Result {
+        //! The block at the requested height when it was prepared, nullptr if there was none.
+        const CBlockIndex* block_index{nullptr};
+        //! What PrepareBlock returned for it.
+        std::optional<std::any> prepared;
+    };
+
+    SyncPipeline(BaseIndex& index, int threads_num, int start_height)
+        : m_index{index}, m_window{threads_num * 8}, m_next_height{start_height}, m_take_height{start_height}
+    {
+        m_threads.reserve(threads_num);
+        for (int n = 0; n < threads_num; ++n) {
+            m_threads.emplace_back(&util::TraceThread, strprintf("idxsync.%i", n), [this] { Work(); });
+        }
+    }
+
+    ~SyncPipeline()
+    {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cv.notify_all();
+        for (std::thread& t : m_threads) {
+            t.join();
+        }
+    }
+
+    /** The height the next Take() returns. */
+    int NextHeight() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) { return WITH_LOCK(m_mutex, return m_take_height); }
+
+    /** Wait for the result at the next height and move on to the one after. */
+    Result Take() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_results.contains(m_take_height); });
+        Result result{std::move(m_results.extract(m_take_height).mapped())};
+        ++m_take_height;
+        // Make room for the workers to prepare another block.
+        m_cv.notify_all();
+        return result;
+    }
+
+private:
+    void Work() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (true) {
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || m_next_height < m_take_height + m_window; });
+            if (m_stop) return;
+            const int height{m_next_height++};
+            Result result;
+            {
+                REVERSE_LOCK(lock, m_mutex);
+                result.block_index = WITH_LOCK(::cs_main, return m_index.m_chainstate->m_chain[height]);
+                if (result.block_index) result.prepared = m_index.PrepareBlock(*result.block_index);
+            }
+            m_results.emplace(height, std::move(result));
+            m_cv.notify_all();
+        }
+    }
+
+    BaseIndex& m_index;
+    const int m_window;
+    std::vector<std::thread> m_threads;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! The next height a worker prepares.
+    int m_next_height GUARDED_BY(m_mutex);
+    //! The height the next Take() returns.
+    int m_take_height GUARDED_BY(m_mutex);
+    //! Prepared blocks that were not taken yet, by height.
+    std::map<int, Result> m_results GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+};
+
 void BaseIndex::Sync()
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
+        const int sync_threads{AllowParallelSync() ? static_cast<int>(std::clamp<int64_t>(gArgs.GetIntArg("-indexsyncthreads", DEFAULT_INDEX_SYNC_THREADS), 1, MAX_INDEX_SYNC_THREADS)) : 1};
+        std::unique_ptr<SyncPipeline> pipeline;
         auto last_log_time{NodeClock::now()};
         auto last_locator_write_time{last_log_time};
         while (true) {
@@ -240,8 +359,35 @@ void BaseIndex::Sync()
             }
             pindex = pindex_next;
 
-
-            if (!ProcessBlock(pindex)) return; // error logged internally
+            if (sync_threads > 1) {
+                // (Re)start the workers at this block if they are elsewhere,
+                // e.g. after a rewind.
+                if (!pipeline || pipeline->NextHeight() != pindex->nHeight) {
+                    pipeline = std::make_unique<SyncPipeline>(*this, sync_threads, pindex->nHeight);
+                }
+                SyncPipeline::Result result{pipeline->Take()};
+                if (result.block_index != pindex) {
+                    // The active chain changed after this height was prepared.
+                    // Discard the prepared blocks and continue from the parent.
+                    pipeline.reset();
+                    pindex = pindex->pprev;
+                    continue;
+                }
+                if (!result.prepared) {
+                    if (m_interrupt) {
+                        // Reads through m_block_reader are cut short when interrupted.
+                        pindex = pindex->pprev;
+                        continue;
+                    }
+                    FatalErrorf("Failed to prepare block %s for %s",
+                                pindex->GetBlockHash().ToString(), GetName());
+                    return;
+                }
+                if (!ProcessPreparedBlock(pindex, std::move(*result.prepared))) return; // error logged internally
+            } else if (!ProcessBlock(pindex)) {
+                return; // error logged internally
+            }
+            if (m_block_reader) m_block_reader->Appended(*this, pindex->nHeight);
 
             auto current_time{NodeClock::now()};
             if (current_time - last_log_time >= SYNC_LOG_INTERVAL) {
@@ -451,11 +597,26 @@ void BaseIndex::Interrupt()
     m_interrupt();
 }
 
+void BaseIndex::ShareBlockReads(IndexBlockReader& block_reader)
+{
+    if (!m_init) throw std::logic_error("Error: Cannot share block reads of a non-initialized index");
+    if (m_synced) return;
+
+    const CBlockIndex* best_block_index{m_best_block_index.load()};
+    block_reader.Register(*this, best_block_index ? best_block_index->nHeight : -1, CustomOptions().connect_undo_data);
+    m_block_reader = &block_reader;
+}
+
 bool BaseIndex::StartBackgroundSync()
 {
     if (!m_init) throw std::logic_error("Error: Cannot start a non-initialized index");
 
-    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] { Sync(); });
+    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] {
+        Sync();
+        // Do not hold back the other indexes once this one stopped syncing.
+        if (m_block_reader) m_block_reader->Unregister(*this);
+        m_block_reader = nullptr;
+    });
     return true;
 }
 
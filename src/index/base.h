@@ -15,6 +15,7 @@
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <any>
 #include <atomic>
 #include <cstddef>
 #include <memory>
@@ -25,6 +26,8 @@
 class CBlock;
 class CBlockIndex;
 class Chainstate;
+class IndexBlockReader;
+struct IndexBlockData;
 
 struct CBlockLocator;
 struct IndexSummary {
@@ -41,6 +44,11 @@ template <unsigned int num_params>
 struct ConstevalFormatString;
 }
 
+/** Default number of threads preparing blocks during the initial sync of indexes that support it. */
+static constexpr int DEFAULT_INDEX_SYNC_THREADS{4};
+/** Maximum number of threads preparing blocks during the initial sync of an index. */
+static constexpr int MAX_INDEX_SYNC_THREADS{64};
+
 /**
  * Base class for indices of blockchain data. This implements
  * CValidationInterface and ensures blocks are indexed sequentially according
@@ -92,6 +100,9 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Shares block reads with other indexes during the initial sync, if set.
+    IndexBlockReader* m_block_reader{nullptr};
+
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
     ///
     /// Recommendations for error handling:
@@ -107,6 +118,19 @@ private:
 
     bool ProcessBlock(const CBlockIndex* pindex, const CBlock* block_data = nullptr);
 
+    /// Read a block, and its undo data if requested, through m_block_reader or from disk.
+    std::optional<IndexBlockData> ReadBlockData(const CBlockIndex& block_index, bool undo);
+
+    /// Read a block (and its undo data if needed) from disk and call CustomPrepare on it.
+    /// Returns std::nullopt on failure.
+    std::optional<std::any> PrepareBlock(const CBlockIndex& block_index);
+
+    /// Pass the result of PrepareBlock to CustomAppendPrepared.
+    bool ProcessPreparedBlock(const CBlockIndex* pindex, std::any prepared);
+
+    /// Worker threads calling PrepareBlock ahead of the sync thread, see Sync().
+    class SyncPipeline;
+
     virtual bool AllowPrune() const = 0;
 
     template <typename... Args>
@@ -130,6 +154,21 @@ protected:
     /// Write update index entries for a newly connected block.
     [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block) { return true; }
 
+    /// Whether the initial sync may use CustomPrepare and CustomAppendPrepared
+    /// instead of CustomAppend, to process blocks on multiple threads.
+    virtual bool AllowParallelSync() const { return false; }
+
+    /// Compute the index entries for a block without writing them. Called on
+    /// worker threads during the initial sync, out of order and concurrently,
+    /// so it may only read state that does not change while syncing. Returns
+    /// std::nullopt on failure.
+    [[nodiscard]] virtual std::optional<std::any> CustomPrepare(const interfaces::BlockInfo& block) const { return std::any{}; }
+
+    /// Write the index entries CustomPrepare computed for a block. Called in
+    /// chain order on the sync thread; block.data and block.undo_data are not
+    /// set.
+    [[nodiscard]] virtual bool CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared) { return true; }
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CustomCommit(CDBBatch& batch) { return true; }
@@ -163,6 +202,12 @@ public:
     /// validation interface so that it stays in sync with blockchain updates.
     [[nodiscard]] bool Init();
 
+    /// Read the blocks of the initial sync through block_reader, sharing the
+    /// reads with the other indexes that sync at the same time. Must be called
+    /// for all of them before any is started, and block_reader must outlive
+    /// the sync thread.
+    void ShareBlockReads(IndexBlockReader& block_reader);
+
     /// Starts the initial sync process on a background thread.
     [[nodiscard]] bool StartBackgroundSync();
 
@@ -171,6 +216,10 @@ public:
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
     /// over and the sync thread exits.
+    ///
+    /// If the index AllowParallelSync(), -indexsyncthreads worker threads read
+    /// and prepare the upcoming blocks out of order, while this thread appends
+    /// them in chain order and advances the best block.
     void Sync();
 
     /// Stops the instance from staying in sync with blockchain updates.
@@ -23,6 +23,7 @@
 #include <util/hasher.h>
 #include <util/syserror.h>
 
+#include <any>
 #include <cerrno>
 #include <exception>
 #include <ios>
@@ -294,8 +295,23 @@ std::optional<uint256> BlockFilterIndex::ReadFilterHeader(int height, const uint
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
     BlockFilter filter(m_filter_type, *Assert(block.data), *Assert(block.undo_data));
+    return AppendFilter(filter, block.height);
+}
+
+std::optional<std::any> BlockFilterIndex::CustomPrepare(const interfaces::BlockInfo& block) const
+{
+    return BlockFilter(m_filter_type, *Assert(block.data), *Assert(block.undo_data));
+}
+
+bool BlockFilterIndex::CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared)
+{
+    return AppendFilter(std::any_cast<const BlockFilter&>(prepared), block.height);
+}
+
+bool BlockFilterIndex::AppendFilter(const BlockFilter& filter, uint32_t block_height)
+{
     const uint256& header = filter.ComputeHeader(m_last_header);
-    bool res = Write(filter, block.height, header);
+    bool res = Write(filter, block_height, header);
     if (res) m_last_header = header; // update last header
     return res;
 }
@@ -60,6 +60,9 @@ private:
 
     bool Write(const BlockFilter& filter, uint32_t block_height, const uint256& filter_header);
 
+    /** Chain a block's filter onto m_last_header and write both. */
+    bool AppendFilter(const BlockFilter& filter, uint32_t block_height);
+
     std::optional<uint256> ReadFilterHeader(int height, const uint256& expected_block_hash);
 
 protected:
@@ -71,6 +74,12 @@ protected:
 
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool AllowParallelSync() const override { return true; }
+
+    std::optional<std::any> CustomPrepare(const interfaces::BlockInfo& block) const override;
+
+    bool CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared) override;
+
     bool CustomRemove(const interfaces::BlockInfo& block) override;
 
     BaseIndex::DB& GetDB() const LIFETIMEBOUND override { return *m_db; }
@@ -0,0 +1,135 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockreader.h>
+
+#include <chain.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <undo.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+using namespace std::chrono_literals;
+
+std::optional<IndexBlockData> ReadIndexBlockData(const node::BlockManager& blockman, const CBlockIndex& block_index, bool undo)
+{
+    IndexBlockData data;
+
+    auto block{std::make_shared<CBlock>()};
+    if (!blockman.ReadBlock(*block, block_index)) {
+        LogError("Failed to read block %s from disk", block_index.GetBlockHash().ToString());
+        return std::nullopt;
+    }
+    data.block = std::move(block);
+
+    if (undo) {
+        auto block_undo{std::make_shared<CBlockUndo>()};
+        if (block_index.nHeight > 0 && !blockman.ReadBlockUndo(*block_undo, block_index)) {
+            LogError("Failed to read undo block data %s from disk", block_index.GetBlockHash().ToString());
+            return std::nullopt;
+        }
+        data.undo = std::move(block_undo);
+    }
+    return data;
+}
+
+IndexBlockReader::IndexBlockReader(const node::BlockManager& blockman)
+    : m_blockman{blockman} {}
+
+void IndexBlockReader::Register(const BaseIndex& index, int start_height, bool undo)
+{
+    LOCK(m_mutex);
+    m_syncing.insert_or_assign(&index, Syncing{.height = start_height, .undo = undo});
+}
+
+void IndexBlockReader::Unregister(const BaseIndex& index)
+{
+    {
+        LOCK(m_mutex);
+        m_syncing.erase(&index);
+        Prune();
+    }
+    m_cv.notify_all();
+}
+
+void IndexBlockReader::Appended(const BaseIndex& index, int height)
+{
+    {
+        LOCK(m_mutex);
+        auto it{m_syncing.find(&index)};
+        if (it == m_syncing.end()) return;
+        it->second.height = height;
+        Prune();
+    }
+    m_cv.notify_all();
+}
+
+bool IndexBlockReader::IsNeeded(int height, const std::set<const BaseIndex*>& readers) const
+{
+    return std::any_of(m_syncing.begin(), m_syncing.end(), [&](const auto& syncing) {
+        return !readers.contains(syncing.first) && syncing.second.height < height && syncing.second.height >= height - SHARE_DISTANCE;
+    });
+}
+
+void IndexBlockReader::Prune()
+{
+    std::erase_if(m_entries, [&](const auto& entry) EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return !IsNeeded(entry.first, entry.second.readers);
+    });
+}
+
+std::optional<IndexBlockData> IndexBlockReader::Read(const BaseIndex& index, const CBlockIndex& block_index, bool undo, const CThreadInterrupt& interrupt)
+{
+    const int height{block_index.nHeight};
+    std::promise<std::optional<IndexBlockData>> promise;
+    std::shared_future<std::optional<IndexBlockData>> data;
+    bool read{false};
+    {
+        WAIT_LOCK(m_mutex, lock);
+        // Do not get too far ahead of the indexes that share this one's reads.
+        const auto too_far_ahead{[&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return std::any_of(m_syncing.begin(), m_syncing.end(), [&](const auto& syncing) {
+                return syncing.first != &index && syncing.second.height >= height - SHARE_DISTANCE && syncing.second.height + SHARE_WINDOW < height;
+            });
+        }};
+        while (!interrupt && too_far_ahead()) {
+            m_cv.wait_for(lock, 100ms);
+        }
+        if (interrupt) return std::nullopt;
+
+        auto it{m_entries.find(height)};
+        if (it != m_entries.end() && (it->second.hash != block_index.GetBlockHash() || (undo && !it->second.undo))) {
+            // The block is from another chain, or the undo data is missing.
+            m_entries.erase(it);
+            it = m_entries.end();
+        }
+        if (it == m_entries.end()) {
+            if (!IsNeeded(height, {&index})) {
+                // No other index is going to need this block.
+                REVERSE_LOCK(lock, m_mutex);
+                ++m_blocks_read;
+                return ReadIndexBlockData(m_blockman, block_index, undo);
+            }
+            // Also read the undo data if another index sharing this read needs it.
+            undo = undo || std::any_of(m_syncing.begin(), m_syncing.end(), [&](const auto& syncing) {
+                return syncing.second.undo && syncing.second.height < height && syncing.second.height >= height - SHARE_DISTANCE;
+            });
+            data = promise.get_future().share();
+            it = m_entries.emplace(height, Entry{.hash = block_index.GetBlockHash(), .undo = undo, .data = data, .readers = {}}).first;
+            read = true;
+        } else {
+            data = it->second.data;
+        }
+        it->second.readers.insert(&index);
+    }
+    if (read) {
+        ++m_blocks_read;
+        promise.set_value(ReadIndexBlockData(m_blockman, block_index, undo));
+    }
+    return data.get();
+}
@@ -0,0 +1,112 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BLOCKREADER_H
+#define BITCOIN_INDEX_BLOCKREADER_H
+
+#include <sync.h>
+#include <uint256.h>
+#include <util/threadinterrupt.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+
+class BaseIndex;
+class CBlock;
+class CBlockIndex;
+class CBlockUndo;
+namespace node {
+class BlockManager;
+}
+
+/** A block and, if requested, its undo data, as read for an index. */
+struct IndexBlockData {
+    std::shared_ptr<const CBlock> block;
+    //! Empty for the genesis block, null if not requested.
+    std::shared_ptr<const CBlockUndo> undo;
+};
+
+/** Read a block, and its undo data if requested, from disk. Returns std::nullopt on failure. */
+std::optional<IndexBlockData> ReadIndexBlockData(const node::BlockManager& blockman, const CBlockIndex& block_index, bool undo);
+
+/**
+ * Reads every block once for all indexes syncing at the same time, instead of
+ * once per index.
+ *
+ * Indexes register with the height they start syncing from and report each
+ * block they append. A block read for one index is kept until every other
+ * registered index that is less than SHARE_DISTANCE blocks behind has read it
+ * as well. To keep those indexes within reach, an index waits before reading
+ * more than SHARE_WINDOW blocks ahead of any of them. Indexes further behind
+ * do not slow the others down; they read the blocks again themselves.
+ */
+class IndexBlockReader
+{
+public:
+    /** How far an index may read ahead of a registered index that shares its reads. */
+    static constexpr int SHARE_WINDOW{32};
+    /** How far behind an index may be to share another index's reads. */
+    static constexpr int SHARE_DISTANCE{2 * SHARE_WINDOW};
+
+    explicit IndexBlockReader(const node::BlockManager& blockman);
+
+    /**
+     * Register an index that is going to sync, reading the blocks after
+     * start_height, with undo data if undo is set.
+     */
+    void Register(const BaseIndex& index, int start_height, bool undo) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Unregister an index that stopped syncing. */
+    void Unregister(const BaseIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Report that a registered index appended the block at a height. */
+    void Appended(const BaseIndex& index, int height) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Return a block, and its undo data if requested, for a registered index.
+     * Returns std::nullopt on failure, or if interrupt was set while waiting
+     * for other indexes to catch up.
+     */
+    std::optional<IndexBlockData> Read(const BaseIndex& index, const CBlockIndex& block_index, bool undo, const CThreadInterrupt& interrupt) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of blocks read from disk so far. */
+    uint64_t GetBlocksRead() const { return m_blocks_read.load(); }
+
+private:
+    struct Syncing {
+        //! The last block the index appended.
+        int height;
+        bool undo;
+    };
+
+    struct Entry {
+        uint256 hash;
+        bool undo;
+        std::shared_future<std::optional<IndexBlockData>> data;
+        //! The indexes that read this entry.
+        std::set<const BaseIndex*> readers;
+    };
+
+    /** Whether an index other than the given ones, that is close enough to share reads, still needs the block at a height. */
+    bool IsNeeded(int height, const std::set<const BaseIndex*>& readers) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Drop the entries no index is going to read anymore. */
+    void Prune() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const node::BlockManager& m_blockman;
+    std::atomic<uint64_t> m_blocks_read{0};
+
+    Mutex m_mutex;
+    //! Notified when an index makes progress or stops syncing.
+    std::condition_variable m_cv;
+    std::map<const BaseIndex*, Syncing> m_syncing GUARDED_BY(m_mutex);
+    std::map<int, Entry> m_entries GUARDED_BY(m_mutex);
+};
+
+#endif // BITCOIN_INDEX_BLOCKREADER_H
@@ -20,11 +20,13 @@
 #include <util/fs.h>
 #include <validation.h>
 
+#include <any>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <iterator>
+#include <optional>
 #include <span>
 #include <string>
 #include <utility>
@@ -73,20 +75,39 @@ TxIndex::TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size,
 
 TxIndex::~TxIndex() = default;
 
-bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
+/** Compute the disk locations of the transactions in a block. */
+static std::vector<std::pair<Txid, CDiskTxPos>> GetTxPositions(const interfaces::BlockInfo& block)
 {
+    std::vector<std::pair<Txid, CDiskTxPos>> vPos;
     // Exclude genesis block transaction because outputs are not spendable.
-    if (block.height == 0) return true;
+    if (block.height == 0) return vPos;
 
     assert(block.data);
     CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
-    std::vector<std::pair<Txid, CDiskTxPos>> vPos;
     vPos.reserve(block.data->vtx.size());
     for (const auto& tx : block.data->vtx) {
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(TX_WITH_WITNESS(*tx));
     }
-    m_db->WriteTxs(vPos);
+    return vPos;
+}
+
+bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    if (block.height == 0) return true;
+    m_db->WriteTxs(GetTxPositions(block));
+    return true;
+}
+
+std::optional<std::any> TxIndex::CustomPrepare(const interfaces::BlockInfo& block) const
+{
+    return GetTxPositions(block);
+}
+
+bool TxIndex::CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared)
+{
+    const auto vPos{std::any_cast<std::vector<std::pair<Txid, CDiskTxPos>>>(std::move(prepared))};
+    if (!vPos.empty()) m_db->WriteTxs(vPos);
     return true;
 }
 
@@ -36,6 +36,12 @@ private:
 protected:
     bool CustomAppend(const interfaces::BlockInfo& block) override;
 
+    bool AllowParallelSync() const override { return true; }
+
+    std::optional<std::any> CustomPrepare(const interfaces::BlockInfo& block) const override;
+
+    bool CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared) override;
+
     BaseIndex::DB& GetDB() const override;
 
 public:
@@ -0,0 +1,159 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/txospenderindex.h>
+
+#include <common/args.h>
+#include <dbwrapper.h>
+#include <index/base.h>
+#include <interfaces/chain.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <util/fs.h>
+
+#include <any>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+static constexpr uint8_t DB_TXOSPENDERINDEX{'s'};
+
+std::unique_ptr<TxoSpenderIndex> g_txospenderindex;
+
+namespace {
+
+struct DBKey {
+    std::array<std::byte, TxoSpenderIndex::TXID_KEY_BYTES> txid_prefix;
+    uint32_t vout;
+
+    explicit DBKey(const COutPoint& outpoint) : vout{outpoint.n}
+    {
+        std::memcpy(txid_prefix.data(), outpoint.hash.data(), txid_prefix.size());
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_TXOSPENDERINDEX);
+        s << txid_prefix << VARINT(vout);
+    }
+};
+
+struct DBVal {
+    Txid txid;
+    uint32_t vin{0};
+    int height{0};
+
+    SERIALIZE_METHODS(DBVal, obj)
+    {
+        READWRITE(obj.txid, VARINT(obj.vin), VARINT_MODE(obj.height, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+using BlockSpenders = std::vector<std::pair<DBKey, DBVal>>;
+
+} // namespace
+
+/** Access to the spent output index database (indexes/txospenderindex/) */
+class TxoSpenderIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+TxoSpenderIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txospenderindex", n_cache_size, f_memory, f_wipe)
+{}
+
+TxoSpenderIndex::TxoSpenderIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "txospenderindex"), m_db(std::make_unique<TxoSpenderIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+TxoSpenderIndex::~TxoSpenderIndex() = default;
+
+interfaces::Chain::NotifyOptions TxoSpenderIndex::CustomOptions()
+{
+    interfaces::Chain::NotifyOptions options;
+    options.disconnect_data = true;
+    return options;
+}
+
+/** Compute the entries for the outputs a block spends. */
+static BlockSpenders GetBlockSpenders(const interfaces::BlockInfo& block)
+{
+    BlockSpenders spenders;
+    assert(block.data);
+    for (const auto& tx : block.data->vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (uint32_t i = 0; i < tx->vin.size(); ++i) {
+            spenders.emplace_back(DBKey{tx->vin[i].prevout}, DBVal{tx->GetHash(), i, block.height});
+        }
+    }
+    return spenders;
+}
+
+bool TxoSpenderIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    return CustomAppendPrepared(block, GetBlockSpenders(block));
+}
+
+std::optional<std::any> TxoSpenderIndex::CustomPrepare(const interfaces::BlockInfo& block) const
+{
+    return GetBlockSpenders(block);
+}
+
+bool TxoSpenderIndex::CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared)
+{
+    const auto spenders{std::any_cast<BlockSpenders>(std::move(prepared))};
+    if (spenders.empty()) return true;
+
+    CDBBatch batch(*m_db);
+    for (const auto& [key, value] : spenders) {
+        batch.Write(key, value);
+    }
+    m_db->WriteBatch(batch);
+    return true;
+}
+
+bool TxoSpenderIndex::CustomRemove(const interfaces::BlockInfo& block)
+{
+    const BlockSpenders spenders{GetBlockSpenders(block)};
+    if (spenders.empty()) return true;
+
+    CDBBatch batch(*m_db);
+    for (const auto& entry : spenders) {
+        batch.Erase(entry.first);
+    }
+    m_db->WriteBatch(batch);
+    return true;
+}
+
+BaseIndex::DB& TxoSpenderIndex::GetDB() const { return *m_db; }
+
+std::optional<TxoSpender> TxoSpenderIndex::FindSpender(const COutPoint& outpoint) const
+{
+    DBVal value;
+    if (!m_db->Read(DBKey{outpoint}, value)) return std::nullopt;
+    return TxoSpender{.txid = value.txid, .vin = value.vin, .height = value.height};
+}
+
+std::vector<std::optional<TxoSpender>> TxoSpenderIndex::FindSpenders(std::span<const COutPoint> outpoints) const
+{
+    std::vector<DBKey> keys;
+    keys.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) keys.emplace_back(outpoint);
+
+    std::vector<std::optional<TxoSpender>> result;
+    result.reserve(outpoints.size());
+    for (const auto& value : m_db->ReadMany<DBVal>(std::span<const DBKey>{keys})) {
+        if (value) {
+            result.push_back(TxoSpender{.txid = value->txid, .vin = value->vin, .height = value->height});
+        } else {
+            result.emplace_back();
+        }
+    }
+    return result;
+}
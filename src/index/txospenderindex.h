@@ -0,0 +1,90 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TXOSPENDERINDEX_H
+#define BITCOIN_INDEX_TXOSPENDERINDEX_H
+
+#include <index/base.h>
+#include <interfaces/chain.h>
+#include <primitives/transaction_identifier.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+class COutPoint;
+
+static constexpr bool DEFAULT_TXOSPENDERINDEX{false};
+
+/** The transaction input spending an output, as recorded by TxoSpenderIndex. */
+struct TxoSpender {
+    Txid txid;
+    //! Index of the input in the transaction.
+    uint32_t vin;
+    //! Height of the block containing the transaction.
+    int height;
+};
+
+/**
+ * TxoSpenderIndex records, for every spent transaction output, the
+ * transaction input that spends it.
+ *
+ * Keys hold the outpoint with the txid truncated to its first
+ * TXID_KEY_BYTES bytes. Txids are hashes, so finding two that share a
+ * truncated prefix takes about 2^64 work, which is out of reach, while the
+ * keys stay less than half the size of a full outpoint.
+ */
+class TxoSpenderIndex final : public BaseIndex
+{
+public:
+    static constexpr size_t TXID_KEY_BYTES{16};
+
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    interfaces::Chain::NotifyOptions CustomOptions() override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool AllowParallelSync() const override { return true; }
+
+    std::optional<std::any> CustomPrepare(const interfaces::BlockInfo& block) const override;
+
+    bool CustomAppendPrepared(const interfaces::BlockInfo& block, std::any prepared) override;
+
+    bool CustomRemove(const interfaces::BlockInfo& block) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit TxoSpenderIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~TxoSpenderIndex() override;
+
+    /// Look up the input spending an output. Returns std::nullopt if the
+    /// output is unspent in the chain the index is synced to.
+    std::optional<TxoSpender> FindSpender(const COutPoint& outpoint) const;
+
+    /// Look up the inputs spending several outputs, from a single consistent
+    /// view of the index.
+    ///
+    /// @return  One entry per outpoint, in the order of outpoints.
+    std::vector<std::optional<TxoSpender>> FindSpenders(std::span<const COutPoint> outpoints) const;
+};
+
+/// The global spent output index. May be null.
+extern std::unique_ptr<TxoSpenderIndex> g_txospenderindex;
+
+#endif // BITCOIN_INDEX_TXOSPENDERINDEX_H
@@ -16,6 +16,7 @@ class CChainParams;
 namespace kernel {
 
 static constexpr bool DEFAULT_XOR_BLOCKSDIR{true};
+static constexpr bool DEFAULT_MMAP_BLOCKS{true};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -24,6 +25,8 @@ static constexpr bool DEFAULT_XOR_BLOCKSDIR{true};
 struct BlockManagerOpts {
     const CChainParams& chainparams;
     bool use_xor{DEFAULT_XOR_BLOCKSDIR};
+    //! Whether to read blocks from memory mapped block files once they are no longer written to.
+    bool mmap_blocks{DEFAULT_MMAP_BLOCKS};
     uint64_t prune_target{0};
     bool fast_prune{false};
     const fs::path blocks_dir;
@@ -22,6 +22,10 @@ class CChainParams;
 class ValidationSignals;
 
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
+static constexpr bool DEFAULT_CONNECT_PIPELINE{true};
+static constexpr int DEFAULT_PREFETCH_THREADS{4};
+static constexpr int MAX_PREFETCH_THREADS{16};
+static constexpr bool DEFAULT_INCREMENTAL_FLUSH{true};
 
 namespace kernel {
 
@@ -46,6 +50,12 @@ struct ChainstateManagerOpts {
     ValidationSignals* signals{nullptr};
     //! Number of script check worker threads. Zero means no parallel verification.
     int worker_threads_num{0};
+    //! Read the next block and prefetch its inputs in the background while the current one is connected.
+    bool connect_pipeline{DEFAULT_CONNECT_PIPELINE};
+    //! Number of connect pipeline worker threads looking up inputs in parallel.
+    int prefetch_threads_num{DEFAULT_PREFETCH_THREADS};
+    //! Remember modified coins so that ChainstateManager::FlushCoinsIncrementally() can write them ahead of full flushes.
+    bool incremental_flush{DEFAULT_INCREMENTAL_FLUSH};
     size_t script_execution_cache_bytes{DEFAULT_SCRIPT_EXECUTION_CACHE_BYTES};
     size_t signature_cache_bytes{DEFAULT_SIGNATURE_CACHE_BYTES};
 };
@@ -11,6 +11,7 @@
 #include <policy/policy.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <txgraph.h>
 #include <util/epochguard.h>
 #include <util/overflow.h>
 
@@ -52,17 +53,22 @@ struct CompareIteratorByHash {
 
 /** \class CTxMemPoolEntry
  *
- * CTxMemPoolEntry stores data about the corresponding transaction, as well
- * as data about all in-mempool transactions that depend on the transaction
- * ("descendant" transactions).
+ * CTxMemPoolEntry stores data about the corresponding transaction, and links
+ * to its direct in-mempool parents and children.
  *
- * When a new entry is added to the mempool, we update the descendant state
- * (m_count_with_descendants, nSizeWithDescendants, and nModFeesWithDescendants) for
- * all ancestors of the newly added transaction.
+ * An entry is also the TxGraph::Ref of its transaction in the mempool's
+ * transaction graph, which groups entries into clusters and linearizes them
+ * into chunks. TxGraph::Ref pointers returned by the graph can be cast back to
+ * the CTxMemPoolEntry. Entries that are not (yet) in a mempool have an empty
+ * Ref.
+ *
+ * Data about all in-mempool ancestors or descendants of a transaction is not
+ * kept in the entry, but calculated from the graph when needed, see
+ * CTxMemPool::CalculateAncestorData() and CalculateDescendantData().
  *
  */
 
-class CTxMemPoolEntry
+class CTxMemPoolEntry : public TxGraph::Ref
 {
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
@@ -71,7 +77,6 @@ public:
     typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
 
 private:
-    CTxMemPoolEntry(const CTxMemPoolEntry&) = default;
     struct ExplicitCopyTag {
         explicit ExplicitCopyTag() = default;
     };
@@ -90,21 +95,6 @@ private:
     CAmount m_modified_fee;         //!< Used for determining the priority of the transaction for mining in a block
     mutable LockPoints lockPoints;  //!< Track the height and time at which tx was final
 
-    // Information about descendants of this transaction that are in the
-    // mempool; if we remove this transaction we must remove all of these
-    // descendants as well.
-    int64_t m_count_with_descendants{1}; //!< number of descendant transactions
-    // Using int64_t instead of int32_t to avoid signed integer overflow issues.
-    int64_t nSizeWithDescendants;      //!< ... and size
-    CAmount nModFeesWithDescendants;   //!< ... and total fees (all including us)
-
-    // Analogous statistics for ancestor transactions
-    int64_t m_count_with_ancestors{1};
-    // Using int64_t instead of int32_t to avoid signed integer overflow issues.
-    int64_t nSizeWithAncestors;
-    CAmount nModFeesWithAncestors;
-    int64_t nSigOpCostWithAncestors;
-
 public:
     CTxMemPoolEntry(const CTransactionRef& tx, CAmount fee,
                     int64_t time, unsigned int entry_height, uint64_t entry_sequence,
@@ -120,14 +110,27 @@ public:
           spendsCoinbase{spends_coinbase},
           sigOpCost{sigops_cost},
           m_modified_fee{nFee},
-          lockPoints{lp},
-          nSizeWithDescendants{GetTxSize()},
-          nModFeesWithDescendants{nFee},
-          nSizeWithAncestors{GetTxSize()},
-          nModFeesWithAncestors{nFee},
-          nSigOpCostWithAncestors{sigOpCost} {}
-
-    CTxMemPoolEntry(ExplicitCopyTag, const CTxMemPoolEntry& entry) : CTxMemPoolEntry(entry) {}
+          lockPoints{lp} {}
+
+    //! The copy is not part of any transaction graph.
+    CTxMemPoolEntry(ExplicitCopyTag, const CTxMemPoolEntry& entry)
+        : TxGraph::Ref{},
+          tx{entry.tx},
+          m_parents{entry.m_parents},
+          m_children{entry.m_children},
+          nFee{entry.nFee},
+          nTxWeight{entry.nTxWeight},
+          nUsageSize{entry.nUsageSize},
+          nTime{entry.nTime},
+          entry_sequence{entry.entry_sequence},
+          entryHeight{entry.entryHeight},
+          spendsCoinbase{entry.spendsCoinbase},
+          sigOpCost{entry.sigOpCost},
+          m_modified_fee{entry.m_modified_fee},
+          lockPoints{entry.lockPoints},
+          idx_randomized{entry.idx_randomized},
+          m_epoch_marker{entry.m_epoch_marker} {}
+    CTxMemPoolEntry(const CTxMemPoolEntry&) = delete;
     CTxMemPoolEntry& operator=(const CTxMemPoolEntry&) = delete;
     CTxMemPoolEntry(CTxMemPoolEntry&&) = delete;
     CTxMemPoolEntry& operator=(CTxMemPoolEntry&&) = delete;
@@ -150,15 +153,9 @@ public:
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
 
-    // Adjusts the descendant state.
-    void UpdateDescendantState(int32_t modifySize, CAmount modifyFee, int64_t modifyCount);
-    // Adjusts the ancestor state
-    void UpdateAncestorState(int32_t modifySize, CAmount modifyFee, int64_t modifyCount, int64_t modifySigOps);
-    // Updates the modified fees with descendants/ancestors.
+    // Updates the modified fee.
     void UpdateModifiedFee(CAmount fee_diff)
     {
-        nModFeesWithDescendants = SaturatingAdd(nModFeesWithDescendants, fee_diff);
-        nModFeesWithAncestors = SaturatingAdd(nModFeesWithAncestors, fee_diff);
         m_modified_fee = SaturatingAdd(m_modified_fee, fee_diff);
     }
 
@@ -168,17 +165,8 @@ public:
         lockPoints = lp;
     }
 
-    uint64_t GetCountWithDescendants() const { return m_count_with_descendants; }
-    int64_t GetSizeWithDescendants() const { return nSizeWithDescendants; }
-    CAmount GetModFeesWithDescendants() const { return nModFeesWithDescendants; }
-
     bool GetSpendsCoinbase() const { return spendsCoinbase; }
 
-    uint64_t GetCountWithAncestors() const { return m_count_with_ancestors; }
-    int64_t GetSizeWithAncestors() const { return nSizeWithAncestors; }
-    CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
-    int64_t GetSigOpCostWithAncestors() const { return nSigOpCostWithAncestors; }
-
     const Parents& GetMemPoolParentsConst() const { return m_parents; }
     const Children& GetMemPoolChildrenConst() const { return m_children; }
     Parents& GetMemPoolParents() const { return m_parents; }
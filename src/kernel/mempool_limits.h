@@ -5,8 +5,10 @@
 #define BITCOIN_KERNEL_MEMPOOL_LIMITS_H
 
 #include <policy/policy.h>
+#include <txgraph.h>
 
 #include <cstdint>
+#include <limits>
 
 namespace kernel {
 /**
@@ -24,6 +26,11 @@ struct MemPoolLimits {
     int64_t descendant_count{DEFAULT_DESCENDANT_LIMIT};
     //! The maximum allowed size in virtual bytes of an entry and its descendants within a package.
     int64_t descendant_size_vbytes{DEFAULT_DESCENDANT_SIZE_LIMIT_KVB * 1'000};
+    //! The maximum allowed number of transactions in a cluster of connected transactions. Unless
+    //! configured lower, this is only the bound the transaction graph can represent.
+    int64_t cluster_count{MAX_CLUSTER_COUNT_LIMIT};
+    //! The maximum allowed size in virtual bytes of a cluster of connected transactions.
+    int64_t cluster_size_vbytes{std::numeric_limits<int64_t>::max()};
 
     /**
      * @return MemPoolLimits with all the limits set to the maximum
@@ -31,7 +38,7 @@ struct MemPoolLimits {
     static constexpr MemPoolLimits NoLimits()
     {
         int64_t no_limit{std::numeric_limits<int64_t>::max()};
-        return {no_limit, no_limit, no_limit, no_limit};
+        return {no_limit, no_limit, no_limit, no_limit, no_limit, no_limit};
     }
 };
 } // namespace kernel
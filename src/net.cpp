@@ -119,9 +119,23 @@ GlobalMutex g_maplocalhost_mutex;
 std::map<CNetAddr, LocalServiceInfo> mapLocalHost GUARDED_BY(g_maplocalhost_mutex);
 std::string strSubVersion;
 
+const uint256& SharedNetMsgPayload::GetHash() const
+{
+    std::call_once(m_hash_once, [&] { m_hash = Hash(m_data); });
+    return m_hash;
+}
+
+size_t SharedNetMsgPayload::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(m_data);
+}
+
 size_t CSerializedNetMsg::GetMemoryUsage() const noexcept
 {
-    return sizeof(*this) + memusage::DynamicUsage(m_type) + memusage::DynamicUsage(data);
+    // A shared payload is counted in full for every message referring to it,
+    // so that send buffer limits work the same as for unshared payloads.
+    return sizeof(*this) + memusage::DynamicUsage(m_type) + memusage::DynamicUsage(data) +
+           (m_shared_payload ? memusage::DynamicUsage(m_shared_payload) + m_shared_payload->DynamicMemoryUsage() : 0);
 }
 
 size_t CNetMessage::GetMemoryUsage() const noexcept
@@ -840,13 +854,13 @@ bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     AssertLockNotHeld(m_send_mutex);
     // Determine whether a new message can be set.
     LOCK(m_send_mutex);
-    if (m_sending_header || m_bytes_sent < m_message_to_send.data.size()) return false;
+    if (m_sending_header || m_bytes_sent < m_message_to_send.Payload().size()) return false;
 
     // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    const uint256 hash{msg.m_shared_payload ? msg.m_shared_payload->GetHash() : Hash(msg.data)};
 
     // create header
-    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.data.size());
+    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.Payload().size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
@@ -868,11 +882,11 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
         return {std::span{m_header_to_send}.subspan(m_bytes_sent),
                 // We have more to send after the header if the message has payload, or if there
                 // is a next message after that.
-                have_next_message || !m_message_to_send.data.empty(),
+                have_next_message || !m_message_to_send.Payload().empty(),
                 m_message_to_send.m_type
                };
     } else {
-        return {std::span{m_message_to_send.data}.subspan(m_bytes_sent),
+        return {m_message_to_send.Payload().subspan(m_bytes_sent),
                 // We only have more to send after this message's payload if there is another
                 // message.
                 have_next_message,
@@ -890,9 +904,10 @@ void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
         // We're done sending a message's header. Switch to sending its data bytes.
         m_sending_header = false;
         m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
+    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.Payload().size()) {
         // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
         ClearShrink(m_message_to_send.data);
+        m_message_to_send.m_shared_payload.reset();
         m_bytes_sent = 0;
     }
 }
@@ -1484,26 +1499,27 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     // is available) and the send buffer is empty. This limits the number of messages in the send
     // buffer to just one, and leaves the responsibility for queueing them up to the caller.
     if (!(m_send_state == SendState::READY && m_send_buffer.empty())) return false;
-    // Construct contents (encoding message type + payload).
-    std::vector<uint8_t> contents;
+    // Construct the encoded message type, which precedes the payload in the contents.
+    std::array<uint8_t, 1 + CMessageHeader::MESSAGE_TYPE_SIZE> type_prefix{};
+    size_t type_prefix_len;
     auto short_message_id = V2_MESSAGE_MAP(msg.m_type);
     if (short_message_id) {
-        contents.resize(1 + msg.data.size());
-        contents[0] = *short_message_id;
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1);
+        type_prefix[0] = *short_message_id;
+        type_prefix_len = 1;
     } else {
-        // Initialize with zeroes, and then write the message type string starting at offset 1.
-        // This means contents[0] and the unused positions in contents[1..13] remain 0x00.
-        contents.resize(1 + CMessageHeader::MESSAGE_TYPE_SIZE + msg.data.size(), 0);
-        std::copy(msg.m_type.begin(), msg.m_type.end(), contents.data() + 1);
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::MESSAGE_TYPE_SIZE);
-    }
-    // Construct ciphertext in send buffer.
-    m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
-    m_cipher.Encrypt(MakeByteSpan(contents), {}, false, MakeWritableByteSpan(m_send_buffer));
+        // Leave type_prefix[0] and the unused positions in type_prefix[1..13] as 0x00.
+        std::copy(msg.m_type.begin(), msg.m_type.end(), type_prefix.data() + 1);
+        type_prefix_len = type_prefix.size();
+    }
+    // Construct ciphertext in send buffer, encrypting the payload in place
+    // rather than copying it next to the message type first.
+    const auto payload{msg.Payload()};
+    m_send_buffer.resize(type_prefix_len + payload.size() + BIP324Cipher::EXPANSION);
+    m_cipher.Encrypt(MakeByteSpan(std::span{type_prefix}.first(type_prefix_len)), MakeByteSpan(payload), {}, false, MakeWritableByteSpan(m_send_buffer));
     m_send_type = msg.m_type;
     // Release memory
     ClearShrink(msg.data);
+    msg.m_shared_payload.reset();
     return true;
 }
 
@@ -3893,10 +3909,10 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
-    size_t nMessageSize = msg.data.size();
+    size_t nMessageSize = msg.Payload().size();
     LogDebug(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type, nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data, /*is_incoming=*/false);
+        CaptureMessage(pnode->addr, msg.m_type, msg.Payload(), /*is_incoming=*/false);
     }
 
     TRACEPOINT(net, outbound_message,
@@ -3904,8 +3920,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->m_addr_name.c_str(),
         pnode->ConnectionTypeAsString().c_str(),
         msg.m_type.c_str(),
-        msg.data.size(),
-        msg.data.data()
+        msg.Payload().size(),
+        msg.Payload().data()
     );
 
     size_t nBytesSent = 0;
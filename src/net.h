@@ -41,6 +41,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <string_view>
@@ -113,6 +114,29 @@ struct AddedNodeInfo {
 class CNodeStats;
 class CClientUIInterface;
 
+/**
+ * A message payload that several CSerializedNetMsg can refer to at once, so
+ * that a large payload sent to many peers, like a block, is built once and not
+ * copied for each of them.
+ */
+class SharedNetMsgPayload
+{
+public:
+    explicit SharedNetMsgPayload(std::vector<unsigned char>&& data) : m_data{std::move(data)} {}
+
+    std::span<const unsigned char> data() const { return m_data; }
+
+    /** Double-SHA256 of the payload, used for the V1 transport checksum. Computed on first use. */
+    const uint256& GetHash() const;
+
+    size_t DynamicMemoryUsage() const;
+
+private:
+    const std::vector<unsigned char> m_data;
+    mutable std::once_flag m_hash_once;
+    mutable uint256 m_hash;
+};
+
 struct CSerializedNetMsg {
     CSerializedNetMsg() = default;
     CSerializedNetMsg(CSerializedNetMsg&&) = default;
@@ -125,13 +149,18 @@ struct CSerializedNetMsg {
     {
         CSerializedNetMsg copy;
         copy.data = data;
+        copy.m_shared_payload = m_shared_payload;
         copy.m_type = m_type;
         return copy;
     }
 
     std::vector<unsigned char> data;
+    /** If set, the payload of the message, and data is empty. */
+    std::shared_ptr<const SharedNetMsgPayload> m_shared_payload;
     std::string m_type;
 
+    std::span<const unsigned char> Payload() const { return m_shared_payload ? m_shared_payload->data() : std::span{data}; }
+
     /** Compute total memory usage of this object (own memory + any dynamic memory). */
     size_t GetMemoryUsage() const noexcept;
 };
@@ -195,6 +195,8 @@ static constexpr double MAX_ADDR_RATE_PER_SECOND{0.1};
 static constexpr size_t MAX_ADDR_PROCESSING_TOKEN_BUCKET{MAX_ADDR_TO_SEND};
 /** The compactblocks version we support. See BIP 152. */
 static constexpr uint64_t CMPCTBLOCKS_VERSION{2};
+/** Total size of raw blocks kept after serving them from disk, so that other peers requesting them are served from memory */
+static constexpr size_t MAX_SERVED_BLOCKS_SIZE{32 << 20};
 
 // Internal stuff
 namespace {
@@ -854,6 +856,19 @@ private:
     uint256 m_most_recent_block_hash GUARDED_BY(m_most_recent_block_mutex);
     std::unique_ptr<const std::map<GenTxid, CTransactionRef>> m_most_recent_block_txs GUARDED_BY(m_most_recent_block_mutex);
 
+    /** Raw blocks recently served from disk, most recently used first, and their total size. */
+    Mutex m_served_blocks_mutex;
+    std::vector<std::pair<uint256, std::shared_ptr<const SharedNetMsgPayload>>> m_served_blocks GUARDED_BY(m_served_blocks_mutex);
+    size_t m_served_blocks_size GUARDED_BY(m_served_blocks_mutex){0};
+
+    /**
+     * Get the raw block at pos as a block message payload, to be shared by
+     * all peers requesting it while it is in m_served_blocks.
+     * Returns nullptr if it cannot be read.
+     */
+    std::shared_ptr<const SharedNetMsgPayload> GetServedBlock(const uint256& hash, const FlatFilePos& pos)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_served_blocks_mutex);
+
     // Data about the low-work headers synchronization, aggregated from all peers' HeadersSyncStates.
     /** Mutex guarding the other m_headers_presync_* variables. */
     Mutex m_headers_presync_mutex;
@@ -947,7 +962,7 @@ private:
         EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, !tx_relay.m_tx_inventory_mutex);
 
     void ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic<bool>& interruptMsgProc)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, peer.m_getdata_requests_mutex, NetEventsInterface::g_msgproc_mutex)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, !m_served_blocks_mutex, peer.m_getdata_requests_mutex, NetEventsInterface::g_msgproc_mutex)
         LOCKS_EXCLUDED(::cs_main);
 
     /** Process a new block. Perform any post-processing housekeeping */
@@ -1001,7 +1016,7 @@ private:
     bool BlockRequestAllowed(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AlreadyHaveBlock(const uint256& block_hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     void ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex, !m_most_recent_block_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex, !m_most_recent_block_mutex, !m_served_blocks_mutex);
 
     /**
      * Validation logic for compact filters request handling.
@@ -2276,8 +2291,10 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
         // as the network format matches the format on disk
-        std::vector<std::byte> block_data;
-        if (!m_chainman.m_blockman.ReadRawBlock(block_data, block_pos)) {
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::BLOCK;
+        msg.m_shared_payload = GetServedBlock(inv.hash, block_pos);
+        if (!msg.m_shared_payload) {
             if (WITH_LOCK(m_chainman.GetMutex(), return m_chainman.m_blockman.IsBlockPruned(*pindex))) {
                 LogDebug(BCLog::NET, "Block was pruned before it could be read, %s\n", pfrom.DisconnectMsg(fLogIPs));
             } else {
@@ -2286,7 +2303,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             pfrom.fDisconnect = true;
             return;
         }
-        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, std::span{block_data});
+        PushMessage(pfrom, std::move(msg));
         // Don't set pblock as we've sent the block
     } else {
         // Send block from disk
@@ -2363,6 +2380,36 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     }
 }
 
+std::shared_ptr<const SharedNetMsgPayload> PeerManagerImpl::GetServedBlock(const uint256& hash, const FlatFilePos& pos)
+{
+    const auto find{[&]() EXCLUSIVE_LOCKS_REQUIRED(m_served_blocks_mutex) {
+        return std::ranges::find(m_served_blocks, hash, &decltype(m_served_blocks)::value_type::first);
+    }};
+    {
+        LOCK(m_served_blocks_mutex);
+        if (const auto it{find()}; it != m_served_blocks.end()) {
+            std::rotate(m_served_blocks.begin(), it, it + 1);
+            return m_served_blocks.front().second;
+        }
+    }
+
+    std::vector<unsigned char> block_data;
+    if (!m_chainman.m_blockman.ReadRawBlock(block_data, pos)) return nullptr;
+    auto payload{std::make_shared<const SharedNetMsgPayload>(std::move(block_data))};
+
+    LOCK(m_served_blocks_mutex);
+    // Another thread may have read the same block in the meantime.
+    if (find() == m_served_blocks.end()) {
+        m_served_blocks.emplace(m_served_blocks.begin(), hash, payload);
+        m_served_blocks_size += payload->data().size();
+        while (m_served_blocks_size > MAX_SERVED_BLOCKS_SIZE) {
+            m_served_blocks_size -= m_served_blocks.back().second->data().size();
+            m_served_blocks.pop_back();
+        }
+    }
+    return payload;
+}
+
 CTransactionRef PeerManagerImpl::FindTxForGetData(const Peer::TxRelay& tx_relay, const GenTxid& gtxid)
 {
     // If a tx was in the mempool prior to the last INV for this peer, permit the request.
@@ -31,6 +31,7 @@
 #include <util/batchpriority.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/mappedfile.h>
 #include <util/obfuscation.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
@@ -39,9 +40,13 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <optional>
+#include <span>
 #include <unordered_map>
 
 namespace kernel {
@@ -82,6 +87,12 @@ bool BlockTreeDB::ReadLastBlockFile(int& nFile)
 void BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo)
 {
     CDBBatch batch(*this);
+    BatchBlockIndex(batch, fileInfo, nLastFile, blockinfo);
+    WriteBatch(batch, true);
+}
+
+void BlockTreeDB::BatchBlockIndex(CDBBatch& batch, const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) const
+{
     for (const auto& [file, info] : fileInfo) {
         batch.Write(std::make_pair(DB_BLOCK_FILES, file), *info);
     }
@@ -89,7 +100,6 @@ void BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFi
     for (const CBlockIndex* bi : blockinfo) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, bi->GetBlockHash()), CDiskBlockIndex{bi});
     }
-    WriteBatch(batch, true);
 }
 
 void BlockTreeDB::WriteFlag(const std::string& name, bool fValue)
@@ -486,20 +496,51 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
 void BlockManager::WriteBlockIndexDB()
 {
     AssertLockHeld(::cs_main);
+    // This is the latest batch, so it is always written.
+    const bool written{WriteBlockIndexBatch(TakeBlockIndexBatch())};
+    Assume(written);
+}
+
+BlockManager::BlockIndexBatch BlockManager::TakeBlockIndexBatch()
+{
+    AssertLockHeld(::cs_main);
+    BlockIndexBatch ret;
+    ret.batch = std::make_unique<CDBBatch>(*m_block_tree_db);
+    ret.db = m_block_tree_db.get();
     std::vector<std::pair<int, const CBlockFileInfo*>> vFiles;
     vFiles.reserve(m_dirty_fileinfo.size());
     for (std::set<int>::iterator it = m_dirty_fileinfo.begin(); it != m_dirty_fileinfo.end();) {
         vFiles.emplace_back(*it, &m_blockfile_info[*it]);
+        ret.files.push_back(*it);
         m_dirty_fileinfo.erase(it++);
     }
     std::vector<const CBlockIndex*> vBlocks;
     vBlocks.reserve(m_dirty_blockindex.size());
     for (std::set<CBlockIndex*>::iterator it = m_dirty_blockindex.begin(); it != m_dirty_blockindex.end();) {
         vBlocks.push_back(*it);
+        ret.blocks.push_back(*it);
         m_dirty_blockindex.erase(it++);
     }
     int max_blockfile = WITH_LOCK(cs_LastBlockFile, return this->MaxBlockfileNum());
-    m_block_tree_db->WriteBatchSync(vFiles, max_blockfile, vBlocks);
+    m_block_tree_db->BatchBlockIndex(*ret.batch, vFiles, max_blockfile, vBlocks);
+    ret.seq = ++m_block_index_batches_taken;
+    return ret;
+}
+
+bool BlockManager::WriteBlockIndexBatch(const BlockIndexBatch& batch)
+{
+    LOCK(m_block_index_write_mutex);
+    if (batch.seq < m_block_index_batch_written) return false;
+    batch.db->WriteBatch(*batch.batch, /*fSync=*/true);
+    m_block_index_batch_written = batch.seq;
+    return true;
+}
+
+void BlockManager::RequeueBlockIndexBatch(const BlockIndexBatch& batch)
+{
+    AssertLockHeld(::cs_main);
+    m_dirty_fileinfo.insert(batch.files.begin(), batch.files.end());
+    m_dirty_blockindex.insert(batch.blocks.begin(), batch.blocks.end());
 }
 
 bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
@@ -771,6 +812,10 @@ uint64_t BlockManager::CalculateCurrentUsage()
 
 void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
 {
+    {
+        LOCK(m_mapped_files_mutex);
+        std::erase_if(m_mapped_files, [&](const auto& entry) { return setFilesToPrune.contains(entry.first); });
+    }
     std::error_code ec;
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
@@ -1001,19 +1046,88 @@ bool BlockManager::WriteBlockUndo(const CBlockUndo& blockundo, BlockValidationSt
     return true;
 }
 
+std::shared_ptr<const MappedFile> BlockManager::GetMappedBlockFile(int file_num) const
+{
+    if (!MappedFile::SUPPORTED || !m_opts.mmap_blocks || MAX_MAPPED_BLOCKFILES == 0) return nullptr;
+
+    const auto find{[&] { return std::ranges::find(m_mapped_files, file_num, &decltype(m_mapped_files)::value_type::first); }};
+    {
+        LOCK(m_mapped_files_mutex);
+        if (const auto it{find()}; it != m_mapped_files.end()) {
+            if (!it->second->Intact()) {
+                LogWarning("Block file %05i shrunk while mapped, reading it without the mapping", file_num);
+                m_mapped_files.erase(it);
+                return nullptr;
+            }
+            std::rotate(m_mapped_files.begin(), it, it + 1);
+            return m_mapped_files.front().second;
+        }
+    }
+
+    {
+        LOCK(cs_LastBlockFile);
+        // Blocks are only appended to the files the cursors point at. A file
+        // is truncated when its cursor moves on, while still holding
+        // cs_LastBlockFile, so files before the newest one that no cursor
+        // points at won't change anymore. Files after the newest one are
+        // only seen while reindexing and may be appended to later.
+        if (file_num >= MaxBlockfileNum()) return nullptr;
+        for (const auto& cursor : m_blockfile_cursors) {
+            if (cursor && cursor->file_num == file_num) return nullptr;
+        }
+    }
+
+    std::shared_ptr<const MappedFile> mapped{MappedFile::Open(m_block_file_seq.FileName(FlatFilePos{file_num, 0}))};
+    if (!mapped) return nullptr;
+
+    LOCK(m_mapped_files_mutex);
+    // Another thread may have mapped the same file in the meantime.
+    if (const auto it{find()}; it != m_mapped_files.end()) return it->second;
+    if (m_mapped_files.size() >= MAX_MAPPED_BLOCKFILES) m_mapped_files.pop_back();
+    m_mapped_files.emplace(m_mapped_files.begin(), file_num, mapped);
+    LogDebug(BCLog::BLOCKSTORAGE, "Mapped block file %05i (%u bytes)\n", file_num, mapped->size());
+    return mapped;
+}
+
+std::span<const std::byte> BlockManager::MappedBlockData(const MappedFile& mapped, const FlatFilePos& pos) const
+{
+    if (pos.nPos < STORAGE_HEADER_BYTES || pos.nPos > mapped.size()) return {};
+
+    const size_t header_pos{pos.nPos - STORAGE_HEADER_BYTES};
+    std::array<std::byte, STORAGE_HEADER_BYTES> header;
+    std::ranges::copy(mapped.data().subspan(header_pos, STORAGE_HEADER_BYTES), header.begin());
+    m_obfuscation(header, header_pos);
+    MessageStartChars blk_start;
+    unsigned int blk_size;
+    SpanReader{header} >> blk_start >> blk_size;
+    if (blk_start != GetParams().MessageStart() || blk_size > MAX_SIZE || blk_size > mapped.size() - pos.nPos) {
+        return {};
+    }
+    return mapped.data().subspan(pos.nPos, blk_size);
+}
+
 bool BlockManager::ReadBlock(CBlock& block, const FlatFilePos& pos, const std::optional<uint256>& expected_hash) const
 {
     block.SetNull();
 
-    // Open history file to read
-    std::vector<std::byte> block_data;
-    if (!ReadRawBlock(block_data, pos)) {
+    // Deserialize straight from the block file if it is mapped, undoing the
+    // obfuscation as the fields are read. Otherwise read it into memory first.
+    const auto mapped{GetMappedBlockFile(pos.nFile)};
+    const std::span<const std::byte> mapped_data{mapped ? MappedBlockData(*mapped, pos) : std::span<const std::byte>{}};
+    std::vector<std::byte> block_buffer;
+    if (mapped_data.empty() && !ReadRawBlock(block_buffer, pos)) {
         return false;
     }
 
     try {
         // Read block
-        SpanReader{block_data} >> TX_WITH_WITNESS(block);
+        if (mapped_data.empty()) {
+            SpanReader{block_buffer} >> TX_WITH_WITNESS(block);
+        } else if (m_obfuscation) {
+            ObfuscatedSpanReader{mapped_data, m_obfuscation, pos.nPos} >> TX_WITH_WITNESS(block);
+        } else {
+            SpanReader{mapped_data} >> TX_WITH_WITNESS(block);
+        }
     } catch (const std::exception& e) {
         LogError("Deserialize or I/O error - %s at %s while reading block", e.what(), pos.ToString());
         return false;
@@ -1048,7 +1162,8 @@ bool BlockManager::ReadBlock(CBlock& block, const CBlockIndex& index) const
     return ReadBlock(block, block_pos, index.GetBlockHash());
 }
 
-bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos& pos) const
+template <typename Byte>
+bool BlockManager::ReadRawBlockImpl(std::vector<Byte>& block, const FlatFilePos& pos) const
 {
     if (pos.nPos < STORAGE_HEADER_BYTES) {
         // If nPos is less than STORAGE_HEADER_BYTES, we can't read the header that precedes the block data
@@ -1057,6 +1172,16 @@ bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos
         LogError("Failed for %s while reading raw block storage header", pos.ToString());
         return false;
     }
+
+    if (const auto mapped{GetMappedBlockFile(pos.nFile)}) {
+        if (const auto data{MappedBlockData(*mapped, pos)}; !data.empty()) {
+            const auto* begin{reinterpret_cast<const Byte*>(data.data())};
+            block.assign(begin, begin + data.size());
+            m_obfuscation(std::as_writable_bytes(std::span{block}), pos.nPos);
+            return true;
+        }
+    }
+
     AutoFile filein{OpenBlockFile({pos.nFile, pos.nPos - STORAGE_HEADER_BYTES}, /*fReadOnly=*/true)};
     if (filein.IsNull()) {
         LogError("OpenBlockFile failed for %s while reading raw block", pos.ToString());
@@ -1082,7 +1207,7 @@ bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos
         }
 
         block.resize(blk_size); // Zeroing of memory is intentional here
-        filein.read(block);
+        filein.read(std::as_writable_bytes(std::span{block}));
     } catch (const std::exception& e) {
         LogError("Read from block file failed: %s for %s while reading raw block", e.what(), pos.ToString());
         return false;
@@ -1091,6 +1216,16 @@ bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos
     return true;
 }
 
+bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos& pos) const
+{
+    return ReadRawBlockImpl(block, pos);
+}
+
+bool BlockManager::ReadRawBlock(std::vector<unsigned char>& block, const FlatFilePos& pos) const
+{
+    return ReadRawBlockImpl(block, pos);
+}
+
 FlatFilePos BlockManager::WriteBlock(const CBlock& block, int nHeight)
 {
     const unsigned int block_size{static_cast<unsigned int>(GetSerializeSize(TX_WITH_WITNESS(block)))};
@@ -39,6 +39,7 @@ class BlockValidationState;
 class CBlockUndo;
 class Chainstate;
 class ChainstateManager;
+class MappedFile;
 namespace Consensus {
 struct Params;
 }
@@ -94,6 +95,8 @@ class BlockTreeDB : public CDBWrapper
 public:
     using CDBWrapper::CDBWrapper;
     void WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
+    //! Add the given entries to batch, as WriteBatchSync() writes them.
+    void BatchBlockIndex(CDBBatch& batch, const std::vector<std::pair<int, const CBlockFileInfo*>>& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) const;
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo& info);
     bool ReadLastBlockFile(int& nFile);
     void WriteReindexing(bool fReindexing);
@@ -116,6 +119,9 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 /** The maximum size of a blk?????.dat file (since 0.8) */
 static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 
+/** The maximum number of blk?????.dat files kept memory mapped for reading. Up to 8 GiB of address space on 64-bit, not used on 32-bit platforms. */
+static constexpr size_t MAX_MAPPED_BLOCKFILES{sizeof(void*) >= 8 ? 64 : 0};
+
 /** Size of header written by WriteBlock before a serialized CBlock (8 bytes) */
 static constexpr uint32_t STORAGE_HEADER_BYTES{std::tuple_size_v<MessageStartChars> + sizeof(unsigned int)};
 
@@ -243,7 +249,7 @@ private:
         const Chainstate& chain,
         ChainstateManager& chainman);
 
-    RecursiveMutex cs_LastBlockFile;
+    mutable RecursiveMutex cs_LastBlockFile;
     std::vector<CBlockFileInfo> m_blockfile_info;
 
     //! Since assumedvalid chainstates may be syncing a range of the chain that is very
@@ -279,12 +285,45 @@ private:
 
     const Obfuscation m_obfuscation;
 
+    /**
+     * Read-only mappings of block files that are no longer written to, most
+     * recently used first. Readers hold on to a mapping through its shared_ptr,
+     * so evicting it does not invalidate blocks that are being read.
+     */
+    mutable Mutex m_mapped_files_mutex;
+    mutable std::vector<std::pair<int, std::shared_ptr<const MappedFile>>> m_mapped_files GUARDED_BY(m_mapped_files_mutex);
+
+    /**
+     * Get a mapping of block file file_num, mapping it if needed. Returns
+     * nullptr if mapping is disabled or not supported, or the file may still
+     * be written to. A mapping of a file that was truncated behind our back is
+     * dropped rather than returned, as reading it could fault.
+     */
+    std::shared_ptr<const MappedFile> GetMappedBlockFile(int file_num) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
+
+    /**
+     * Returns the still obfuscated serialized block at pos in mapped, after
+     * checking the storage header in front of it. Returns an empty span if the
+     * block does not lie within the mapping or the header does not look right,
+     * in which case the block should be read from the file, which reports any
+     * errors.
+     */
+    std::span<const std::byte> MappedBlockData(const MappedFile& mapped, const FlatFilePos& pos) const;
+
+    template <typename Byte>
+    bool ReadRawBlockImpl(std::vector<Byte>& block, const FlatFilePos& pos) const;
+
     /** Dirty block index entries. */
     std::set<CBlockIndex*> m_dirty_blockindex;
 
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
+    /** Number of batches taken by TakeBlockIndexBatch(), and the last one of them written. */
+    uint64_t m_block_index_batches_taken GUARDED_BY(::cs_main){0};
+    Mutex m_block_index_write_mutex;
+    uint64_t m_block_index_batch_written GUARDED_BY(m_block_index_write_mutex){0};
+
     /**
      * Map from external index name to oldest block that must not be pruned.
      *
@@ -342,7 +381,29 @@ public:
 
     std::unique_ptr<BlockTreeDB> m_block_tree_db GUARDED_BY(::cs_main);
 
-    void WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    void WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_block_index_write_mutex);
+
+    /** Dirty block index entries and block file info, serialized to be written without cs_main. */
+    struct BlockIndexBatch {
+        std::unique_ptr<CDBBatch> batch;
+        BlockTreeDB* db{nullptr};
+        //! The entries in the batch, for RequeueBlockIndexBatch().
+        std::vector<int> files;
+        std::vector<CBlockIndex*> blocks;
+        uint64_t seq{0};
+    };
+    //! Take the dirty entries out of the block index for WriteBlockIndexBatch().
+    BlockIndexBatch TakeBlockIndexBatch() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /**
+     * Write and sync a batch taken by TakeBlockIndexBatch(), unless one that
+     * was taken later has been written already.
+     * @returns false in that case, as the entries might be overwritten with
+     *          older data. They then have to be passed to RequeueBlockIndexBatch().
+     */
+    bool WriteBlockIndexBatch(const BlockIndexBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(!m_block_index_write_mutex);
+    //! Mark the entries of a batch that could not be written as dirty again.
+    void RequeueBlockIndexBatch(const BlockIndexBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     bool LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
@@ -450,12 +511,17 @@ public:
     /**
      *  Actually unlink the specified files
      */
-    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const;
+    void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
 
     /** Functions for disk access for blocks */
-    bool ReadBlock(CBlock& block, const FlatFilePos& pos, const std::optional<uint256>& expected_hash) const;
-    bool ReadBlock(CBlock& block, const CBlockIndex& index) const;
-    bool ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos& pos) const;
+    bool ReadBlock(CBlock& block, const FlatFilePos& pos, const std::optional<uint256>& expected_hash) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
+    bool ReadBlock(CBlock& block, const CBlockIndex& index) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
+    bool ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
+    //! Same as above, for reading straight into a network message.
+    bool ReadRawBlock(std::vector<unsigned char>& block, const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex);
+
+    //! Number of block files currently mapped.
+    size_t MappedBlockFileCount() const EXCLUSIVE_LOCKS_REQUIRED(!m_mapped_files_mutex) { return WITH_LOCK(m_mapped_files_mutex, return m_mapped_files.size()); }
 
     bool ReadBlockUndo(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
@@ -20,6 +20,8 @@ static constexpr size_t DEFAULT_DB_CACHE{DEFAULT_KERNEL_CACHE};
 namespace node {
 struct IndexCacheSizes {
     size_t tx_index{0};
+    size_t addr_index{0};
+    size_t txospender_index{0};
     size_t filter_index{0};
 };
 struct CacheSizes {
@@ -59,6 +59,10 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
     // Subtract 1 because the main thread counts towards the par threads.
     opts.worker_threads_num = script_threads - 1;
 
+    opts.connect_pipeline = args.GetBoolArg("-connectpipeline", opts.connect_pipeline);
+    if (auto value{args.GetIntArg("-prefetchthreads")}) opts.prefetch_threads_num = *value;
+    opts.incremental_flush = args.GetBoolArg("-incrementalflush", opts.incremental_flush);
+
     if (auto max_size = args.GetIntArg("-maxsigcachesize")) {
         // 1. When supplied with a max_size of 0, both the signature cache and
         //    script execution cache create the minimum possible cache (2
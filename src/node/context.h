@@ -23,6 +23,7 @@ class CScheduler;
 class CTxMemPool;
 class ChainstateManager;
 class ECC_Context;
+class IndexBlockReader;
 class NetGroupManager;
 class PeerManager;
 namespace interfaces {
@@ -73,6 +74,8 @@ struct NodeContext {
     std::unique_ptr<BanMan> banman;
     ArgsManager* args{nullptr}; // Currently a raw pointer because the memory is not managed by this struct
     std::vector<BaseIndex*> indexes; // raw pointers because memory is not managed by this struct
+    //! Shares block reads between the indexes syncing at startup.
+    std::unique_ptr<IndexBlockReader> index_block_reader;
     std::unique_ptr<interfaces::Chain> chain;
     //! List of all chain clients (wallet processes or other client) connected to node.
     std::vector<std::unique_ptr<interfaces::ChainClient>> chain_clients;
@@ -667,7 +667,7 @@ public:
         LOCK(m_node.mempool->cs);
         const auto entry{m_node.mempool->GetEntry(txid)};
         if (entry == nullptr) return false;
-        return entry->GetCountWithDescendants() > 1;
+        return !entry->GetMemPoolChildrenConst().empty();
     }
     bool broadcastTransaction(const CTransactionRef& tx,
         const CAmount& max_tx_fee,
@@ -15,6 +15,7 @@
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <tinyformat.h>
+#include <txgraph.h>
 #include <util/moneystr.h>
 #include <util/translation.h>
 
@@ -38,6 +39,10 @@ void ApplyArgsManOptions(const ArgsManager& argsman, MemPoolLimits& mempool_limi
     mempool_limits.descendant_count = argsman.GetIntArg("-limitdescendantcount", mempool_limits.descendant_count);
 
     if (auto vkb = argsman.GetIntArg("-limitdescendantsize")) mempool_limits.descendant_size_vbytes = *vkb * 1'000;
+
+    mempool_limits.cluster_count = argsman.GetIntArg("-limitclustercount", mempool_limits.cluster_count);
+
+    if (auto vkb = argsman.GetIntArg("-limitclustersize")) mempool_limits.cluster_size_vbytes = *vkb * 1'000;
 }
 }
 
@@ -105,6 +110,9 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& argsman, const CChainP
     mempool_opts.persist_v1_dat = argsman.GetBoolArg("-persistmempoolv1", mempool_opts.persist_v1_dat);
 
     ApplyArgsManOptions(argsman, mempool_opts.limits);
+    if (mempool_opts.limits.cluster_count < 1 || mempool_opts.limits.cluster_count > MAX_CLUSTER_COUNT_LIMIT) {
+        return util::Error{Untranslated(strprintf("-limitclustercount must be between 1 and %u", MAX_CLUSTER_COUNT_LIMIT))};
+    }
 
     return {};
 }
@@ -17,6 +17,7 @@
 #include <util/rbf.h>
 
 #include <limits>
+#include <tuple>
 #include <vector>
 
 #include <compare>
@@ -39,8 +40,7 @@ RBFTransactionState IsRBFOptIn(const CTransaction& tx, const CTxMemPool& pool)
     // If all the inputs have nSequence >= maxint-1, it still might be
     // signaled for RBF if any unconfirmed parents have signaled.
     const auto& entry{*Assert(pool.GetEntry(tx.GetHash()))};
-    auto ancestors{pool.AssumeCalculateMemPoolAncestors(__func__, entry, CTxMemPool::Limits::NoLimits(),
-                                                        /*fSearchForParents=*/false)};
+    const auto ancestors{pool.GetAncestors(entry)};
 
     for (CTxMemPool::txiter it : ancestors) {
         if (SignalsOptInRBF(it->GetTx())) {
@@ -64,7 +64,7 @@ std::optional<std::string> GetEntriesForConflicts(const CTransaction& tx,
     AssertLockHeld(pool.cs);
     uint64_t nConflictingCount = 0;
     for (const auto& mi : iters_conflicting) {
-        nConflictingCount += mi->GetCountWithDescendants();
+        nConflictingCount += std::get<0>(pool.CalculateDescendantData(*mi));
         // Rule #5: don't consider replacing more than MAX_REPLACEMENT_CANDIDATES
         // entries from the mempool. This potentially overestimates the number of actual
         // descendants (i.e. if multiple conflicts share a descendant, it will be counted multiple
@@ -8,11 +8,14 @@
 #include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <common/system.h>
 #include <core_io.h>
 #include <flatfile.h>
 #include <httpserver.h>
+#include <index/addrindex.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
+#include <index/txospenderindex.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
@@ -24,13 +27,16 @@
 #include <rpc/server_util.h>
 #include <streams.h>
 #include <sync.h>
+#include <txdb.h>
 #include <txmempool.h>
 #include <undo.h>
 #include <util/any.h>
 #include <util/check.h>
 #include <util/strencodings.h>
+#include <util/threadpool.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <any>
 #include <vector>
 
@@ -42,6 +48,13 @@ using util::SplitString;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+static constexpr size_t MAX_TXOSPENDERS_OUTPOINTS{10000};
+static constexpr size_t MAX_BULK_UTXOS_OUTPOINTS{100000};
+//! Maximum number of threads looking up coins for /rest/bulkutxos/.
+static constexpr int MAX_BULK_UTXOS_LOOKUP_THREADS{4};
+
+//! Workers spreading the database lookups of bulk UTXO queries.
+static ThreadPool g_utxo_lookup_pool{"restutxo"};
 
 static const struct {
     RESTResponseFormat rf;
@@ -1053,6 +1066,230 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     }
 }
 
+static bool rest_txospenders(const std::any& context, HTTPRequest* req, const std::string& uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, uri_part);
+
+    std::vector<std::string> uri_parts;
+    if (param.length() > 1) {
+        uri_parts = SplitString(param.substr(1), '/');
+    }
+
+    std::string request_body = req->ReadBody();
+    if (request_body.empty() && uri_parts.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    }
+
+    // outpoints are sent over the URI scheme (/rest/txospenders/txid1-n/txid2-n/...),
+    // or for the binary and hex formats as a serialized vector in the request body.
+    std::vector<COutPoint> outpoints;
+    for (const std::string& uri_part : uri_parts) {
+        const auto txid_out{util::Split<std::string_view>(uri_part, '-')};
+        if (txid_out.size() != 2) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        auto txid{Txid::FromHex(txid_out.at(0))};
+        auto output{ToIntegral<uint32_t>(txid_out.at(1))};
+        if (!txid || !output) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        outpoints.emplace_back(*txid, *output);
+    }
+
+    switch (rf) {
+    case RESTResponseFormat::HEX: {
+        const std::vector<unsigned char> request_bytes{ParseHex(request_body)};
+        request_body.assign(request_bytes.begin(), request_bytes.end());
+        [[fallthrough]];
+    }
+    case RESTResponseFormat::BINARY: {
+        if (request_body.empty()) break;
+        if (!outpoints.empty()) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Combination of URI scheme inputs and raw post data is not allowed");
+        }
+        try {
+            SpanReader{MakeByteSpan(request_body)} >> outpoints;
+        } catch (const std::ios_base::failure&) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        break;
+    }
+    case RESTResponseFormat::JSON: {
+        break;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    if (outpoints.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    }
+    if (outpoints.size() > MAX_TXOSPENDERS_OUTPOINTS) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", MAX_TXOSPENDERS_OUTPOINTS, outpoints.size()));
+    }
+
+    if (!g_txospenderindex) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Spent output index is not enabled");
+    }
+    if (!g_txospenderindex->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Spent output index is still syncing");
+    }
+
+    const IndexSummary summary{g_txospenderindex->GetSummary()};
+    const std::vector<std::optional<TxoSpender>> spenders{g_txospenderindex->FindSpenders(outpoints)};
+    std::vector<unsigned char> bitmap((outpoints.size() + 7) / 8);
+    for (size_t i = 0; i < spenders.size(); ++i) {
+        if (spenders[i]) bitmap[i / 8] |= uint8_t(1) << (i % 8);
+    }
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY:
+    case RESTResponseFormat::HEX: {
+        DataStream response{};
+        response << summary.best_block_height << summary.best_block_hash << bitmap;
+        WriteCompactSize(response, std::ranges::count_if(spenders, [](const auto& spender) { return spender.has_value(); }));
+        for (const auto& spender : spenders) {
+            if (spender) response << spender->txid << spender->vin << spender->height;
+        }
+        if (rf == RESTResponseFormat::HEX) {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(response) + "\n");
+        } else {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, response);
+        }
+        return true;
+    }
+    case RESTResponseFormat::JSON: {
+        UniValue result(UniValue::VOBJ);
+        result.pushKV("chainHeight", summary.best_block_height);
+        result.pushKV("chaintipHash", summary.best_block_hash.GetHex());
+
+        UniValue entries(UniValue::VARR);
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("txid", outpoints[i].hash.GetHex());
+            entry.pushKV("vout", outpoints[i].n);
+            if (const auto& spender{spenders[i]}) {
+                entry.pushKV("spendingtxid", spender->txid.GetHex());
+                entry.pushKV("vin", spender->vin);
+                entry.pushKV("height", spender->height);
+            }
+            entries.push_back(std::move(entry));
+        }
+        result.pushKV("spenders", std::move(entries));
+
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, result.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_bulk_utxos(const std::any& context, HTTPRequest* req, const std::string& uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, uri_part);
+    if (!param.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: outpoints must be posted in the request body");
+    }
+
+    std::string request_body = req->ReadBody();
+    switch (rf) {
+    case RESTResponseFormat::HEX: {
+        const std::vector<unsigned char> request_bytes{ParseHex(request_body)};
+        request_body.assign(request_bytes.begin(), request_bytes.end());
+        break;
+    }
+    case RESTResponseFormat::BINARY: {
+        break;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: bin, hex)");
+    }
+    }
+
+    std::vector<COutPoint> outpoints;
+    try {
+        SpanReader{MakeByteSpan(request_body)} >> outpoints;
+    } catch (const std::ios_base::failure&) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    }
+    if (outpoints.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    }
+    if (outpoints.size() > MAX_BULK_UTXOS_OUTPOINTS) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", MAX_BULK_UTXOS_OUTPOINTS, outpoints.size()));
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    ChainstateManager& chainman = *maybe_chainman;
+
+    // Resolve the outpoints held in the coins cache under cs_main, and take a
+    // snapshot of the coins database for the others. The database is only
+    // written to under cs_main and holds the current state of every coin the
+    // cache does not, so the snapshot stays consistent with the tip while the
+    // remaining lookups run without the lock.
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<COutPoint> db_outpoints;
+    std::vector<size_t> db_positions;
+    const CCoinsViewDB* coins_db;
+    std::unique_ptr<CDBSnapshot> snapshot;
+    int active_height;
+    uint256 active_hash;
+    {
+        LOCK(cs_main);
+        Chainstate& chainstate{chainman.ActiveChainstate()};
+        const CCoinsViewCache& coins_tip{chainstate.CoinsTip()};
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            if (auto coin{coins_tip.PeekCoin(outpoints[i])}) {
+                if (!coin->IsSpent()) coins[i] = std::move(*coin);
+            } else {
+                db_outpoints.push_back(outpoints[i]);
+                db_positions.push_back(i);
+            }
+        }
+        coins_db = &chainstate.CoinsDB();
+        snapshot = coins_db->GetSnapshot();
+        active_height = chainman.ActiveHeight();
+        active_hash = chainman.ActiveTip()->GetBlockHash();
+    }
+    std::vector<std::optional<Coin>> db_coins{coins_db->GetCoins(db_outpoints, *snapshot, &g_utxo_lookup_pool)};
+    snapshot.reset();
+    for (size_t i = 0; i < db_positions.size(); ++i) {
+        coins[db_positions[i]] = std::move(db_coins[i]);
+    }
+
+    std::vector<unsigned char> bitmap((outpoints.size() + 7) / 8);
+    std::vector<CCoin> outs;
+    for (size_t i = 0; i < coins.size(); ++i) {
+        if (!coins[i]) continue;
+        bitmap[i / 8] |= uint8_t(1) << (i % 8);
+        outs.emplace_back(std::move(*coins[i]));
+    }
+
+    DataStream response{};
+    response << active_height << active_hash << bitmap << outs;
+    if (rf == RESTResponseFormat::HEX) {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(response) + "\n");
+    } else {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, response);
+    }
+    return true;
+}
+
 static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
                        const std::string& str_uri_part)
 {
@@ -1103,6 +1340,66 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
     }
 }
 
+static bool rest_address_history(const std::any& context, HTTPRequest* req, const std::string& uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, uri_part);
+
+    // request is sent over URI scheme /rest/addresshistory/<address|scripthash>?skip=<skip>&count=<count>
+    std::vector<std::string> uri_parts = SplitString(param, '/');
+    if (uri_parts.size() != 1) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/addresshistory/<address|scripthash>.json?skip=<skip>&count=<count>");
+    }
+
+    const auto script_hash{ParseAddressHistoryTarget(uri_parts[0])};
+    if (!script_hash) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address or script hash: " + uri_parts[0]);
+    }
+
+    std::string raw_skip, raw_count;
+    try {
+        raw_skip = req->GetQueryParameter("skip").value_or("0");
+        raw_count = req->GetQueryParameter("count").value_or(util::ToString(DEFAULT_ADDRESS_HISTORY_RESULTS));
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+    const auto skip{ToIntegral<size_t>(raw_skip)};
+    if (!skip) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid skip: " + raw_skip);
+    }
+    const auto count{ToIntegral<size_t>(raw_count)};
+    if (!count || *count < 1 || *count > MAX_ADDRESS_HISTORY_RESULTS) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Count is invalid or out of acceptable range (1-%u): %s", MAX_ADDRESS_HISTORY_RESULTS, raw_count));
+    }
+
+    if (!g_addr_index) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Address index is not enabled");
+    }
+    if (!g_addr_index->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Address index is still syncing");
+    }
+
+    ChainstateManager* chainman = GetChainman(context, req);
+    if (!chainman) return false;
+
+    switch (rf) {
+    case RESTResponseFormat::JSON: {
+        const auto result{AddressHistoryToJSON(*chainman, *g_addr_index, *script_hash, *skip, *count)};
+        if (!result) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Unable to read the address index");
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, result->write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
@@ -1116,10 +1413,13 @@ static const struct {
       {"/rest/mempool/", rest_mempool},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/bulkutxos", rest_bulk_utxos},
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
       {"/rest/spenttxouts/", rest_spent_txouts},
+      {"/rest/addresshistory/", rest_address_history},
+      {"/rest/txospenders", rest_txospenders},
 };
 
 void StartREST(const std::any& context)
@@ -1128,6 +1428,7 @@ void StartREST(const std::any& context)
         auto handler = [context, up](HTTPRequest* req, const std::string& prefix) { return up.handler(context, req, prefix); };
         RegisterHTTPHandler(up.prefix, false, handler);
     }
+    g_utxo_lookup_pool.Start(std::clamp(GetNumCores(), 1, MAX_BULK_UTXOS_LOOKUP_THREADS));
 }
 
 void InterruptREST()
@@ -1139,4 +1440,5 @@ void StopREST()
     for (const auto& up : uri_prefixes) {
         UnregisterHTTPHandler(up.prefix, false);
     }
+    g_utxo_lookup_pool.Stop();
 }
@@ -20,9 +20,11 @@
 #include <deploymentstatus.h>
 #include <flatfile.h>
 #include <hash.h>
+#include <index/addrindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <interfaces/mining.h>
+#include <key_io.h>
 #include <kernel/coinstats.h>
 #include <logging/timer.h>
 #include <net.h>
@@ -33,6 +35,7 @@
 #include <node/utxo_snapshot.h>
 #include <node/warnings.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -57,6 +60,7 @@
 #include <cstdint>
 
 #include <condition_variable>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <mutex>
@@ -181,20 +185,13 @@ UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex
     return result;
 }
 
-UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity, const uint256 pow_limit)
+/** Call fn with the description of each transaction of block, as listed by blockToJSON */
+static void ForEachTxToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& blockindex, TxVerbosity verbosity, const std::function<void(UniValue)>& fn)
 {
-    UniValue result = blockheaderToJSON(tip, blockindex, pow_limit);
-
-    result.pushKV("strippedsize", ::GetSerializeSize(TX_NO_WITNESS(block)));
-    result.pushKV("size", ::GetSerializeSize(TX_WITH_WITNESS(block)));
-    result.pushKV("weight", ::GetBlockWeight(block));
-    UniValue txs(UniValue::VARR);
-    txs.reserve(block.vtx.size());
-
     switch (verbosity) {
         case TxVerbosity::SHOW_TXID:
             for (const CTransactionRef& tx : block.vtx) {
-                txs.push_back(tx->GetHash().GetHex());
+                fn(tx->GetHash().GetHex());
             }
             break;
 
@@ -212,16 +209,41 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
                 const CTxUndo* txundo = (have_undo && i > 0) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
                 UniValue objTx(UniValue::VOBJ);
                 TxToUniv(*tx, /*block_hash=*/uint256(), /*entry=*/objTx, /*include_hex=*/true, txundo, verbosity);
-                txs.push_back(std::move(objTx));
+                fn(std::move(objTx));
             }
             break;
     }
+}
 
+UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity, const uint256 pow_limit)
+{
+    UniValue result = blockheaderToJSON(tip, blockindex, pow_limit);
+
+    result.pushKV("strippedsize", ::GetSerializeSize(TX_NO_WITNESS(block)));
+    result.pushKV("size", ::GetSerializeSize(TX_WITH_WITNESS(block)));
+    result.pushKV("weight", ::GetBlockWeight(block));
+    UniValue txs(UniValue::VARR);
+    txs.reserve(block.vtx.size());
+    ForEachTxToJSON(blockman, block, blockindex, verbosity, [&](UniValue tx) { txs.push_back(std::move(tx)); });
     result.pushKV("tx", std::move(txs));
 
     return result;
 }
 
+void blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity, const uint256 pow_limit, JSONStreamWriter& out)
+{
+    out.BeginObject();
+    out.Members(blockheaderToJSON(tip, blockindex, pow_limit));
+    out.KeyValue("strippedsize", ::GetSerializeSize(TX_NO_WITNESS(block)));
+    out.KeyValue("size", ::GetSerializeSize(TX_WITH_WITNESS(block)));
+    out.KeyValue("weight", ::GetBlockWeight(block));
+    out.Key("tx");
+    out.BeginArray();
+    ForEachTxToJSON(blockman, block, blockindex, verbosity, [&](UniValue tx) { out.Value(tx); });
+    out.EndArray();
+    out.EndObject();
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{
@@ -849,6 +871,13 @@ static RPCHelpMan getblock()
         tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
     }
 
+    if (tx_verbosity != TxVerbosity::SHOW_TXID && request.m_result_stream) {
+        // Write the transactions out one at a time instead of building the
+        // description of the whole block in memory first.
+        blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity, chainman.GetConsensus().powLimit, *request.m_result_stream);
+        return UniValue{};
+    }
+
     return blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity, chainman.GetConsensus().powLimit);
 },
     };
@@ -1047,6 +1076,8 @@ static RPCHelpMan gettxoutsetinfo()
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
     Chainstate& active_chainstate = chainman.ActiveChainstate();
+    // Keep the database consistent with a single block while it is read below.
+    const IncrementalFlushBlocker flush_blocker{active_chainstate};
     active_chainstate.ForceFlushStateToDisk();
 
     CCoinsView* coins_view;
@@ -1362,6 +1393,27 @@ RPCHelpMan getblockchaininfo()
                 {RPCResult::Type::BOOL, "automatic_pruning", /*optional=*/true, "whether automatic pruning is enabled (only present if pruning is enabled)"},
                 {RPCResult::Type::NUM, "prune_target_size", /*optional=*/true, "the target size used by pruning (only present if automatic pruning is enabled)"},
                 {RPCResult::Type::STR_HEX, "signet_challenge", /*optional=*/true, "the block challenge (aka. block script), in hexadecimal (only present if the current network is a signet)"},
+                {RPCResult::Type::OBJ, "inputprefetch", /*optional=*/true, "statistics of the block input prefetcher (only present if -connectpipeline is enabled)",
+                {
+                    {RPCResult::Type::NUM, "threads", "the number of threads looking up inputs"},
+                    {RPCResult::Type::NUM, "lookups", "the number of inputs looked up in the chainstate database ahead of block connection"},
+                    {RPCResult::Type::NUM, "hits", "the number of prefetched inputs that were used when connecting blocks"},
+                    {RPCResult::Type::NUM, "wasted", "the number of lookups that did not produce a used input"},
+                    {RPCResult::Type::NUM, "hitrate", "hits divided by lookups, or 0 if there were no lookups"},
+                }},
+                {RPCResult::Type::OBJ, "coinsflush", "statistics of writes of the coins cache to the chainstate database",
+                {
+                    {RPCResult::Type::BOOL, "incremental", "whether modified coins are written in small batches ahead of full flushes (see -incrementalflush)"},
+                    {RPCResult::Type::NUM, "queued", "the number of modified coins waiting to be written incrementally"},
+                    {RPCResult::Type::NUM, "incremental_flushes", "the number of incremental flushes that wrote coins"},
+                    {RPCResult::Type::NUM, "incremental_coins", "the number of coins written by incremental flushes"},
+                    {RPCResult::Type::NUM, "last_incremental_ms", "the time cs_main was held by the last incremental flush, in milliseconds"},
+                    {RPCResult::Type::NUM, "max_incremental_ms", "the longest time cs_main was held by an incremental flush, in milliseconds"},
+                    {RPCResult::Type::NUM, "full_flushes", "the number of flushes that wrote all modified coins"},
+                    {RPCResult::Type::NUM, "last_full_coins", "the number of coins in the cache at the last full flush"},
+                    {RPCResult::Type::NUM, "last_full_ms", "the time cs_main was held by the last full flush, in milliseconds"},
+                    {RPCResult::Type::NUM, "max_full_ms", "the longest time cs_main was held by a full flush, in milliseconds"},
+                }},
                 (IsDeprecatedRPCEnabled("warnings") ?
                     RPCResult{RPCResult::Type::STR, "warnings", "any network and blockchain warnings (DEPRECATED)"} :
                     RPCResult{RPCResult::Type::ARR, "warnings", "any network and blockchain warnings (run with `-deprecatedrpc=warnings` to return the latest warning as a single string)",
@@ -1413,6 +1465,31 @@ RPCHelpMan getblockchaininfo()
             chainman.GetParams().GetConsensus().signet_challenge;
         obj.pushKV("signet_challenge", HexStr(signet_challenge));
     }
+    if (const size_t threads{chainman.GetConnectPipeline().WorkersCount()}) {
+        const auto stats{active_chainstate.CoinsPrefetch().GetStats()};
+        UniValue prefetch(UniValue::VOBJ);
+        prefetch.pushKV("threads", threads);
+        prefetch.pushKV("lookups", stats.lookups);
+        prefetch.pushKV("hits", stats.hits);
+        prefetch.pushKV("wasted", stats.wasted);
+        prefetch.pushKV("hitrate", stats.lookups ? double(stats.hits) / stats.lookups : 0.0);
+        obj.pushKV("inputprefetch", std::move(prefetch));
+    }
+    {
+        const auto stats{active_chainstate.GetCoinsFlushStats()};
+        UniValue flush(UniValue::VOBJ);
+        flush.pushKV("incremental", chainman.m_options.incremental_flush);
+        flush.pushKV("queued", uint64_t{active_chainstate.CoinsTip().GetPartialSyncQueueSize()});
+        flush.pushKV("incremental_flushes", stats.incremental_flushes);
+        flush.pushKV("incremental_coins", stats.incremental_coins);
+        flush.pushKV("last_incremental_ms", Ticks<MillisecondsDouble>(stats.last_incremental_time));
+        flush.pushKV("max_incremental_ms", Ticks<MillisecondsDouble>(stats.max_incremental_time));
+        flush.pushKV("full_flushes", stats.full_flushes);
+        flush.pushKV("last_full_coins", stats.last_full_coins);
+        flush.pushKV("last_full_ms", Ticks<MillisecondsDouble>(stats.last_full_time));
+        flush.pushKV("max_full_ms", Ticks<MillisecondsDouble>(stats.max_full_time));
+        obj.pushKV("coinsflush", std::move(flush));
+    }
 
     NodeContext& node = EnsureAnyNodeContext(request.context);
     obj.pushKV("warnings", node::GetWarningsForRpc(*CHECK_NONFATAL(node.warnings), IsDeprecatedRPCEnabled("warnings")));
@@ -2906,6 +2983,120 @@ static RPCHelpMan getdescriptoractivity()
     };
 }
 
+std::optional<uint256> ParseAddressHistoryTarget(std::string_view target)
+{
+    // A script hash is never a valid address.
+    if (target.size() == 64 && IsHex(target)) return uint256::FromHex(target);
+    const CTxDestination dest{DecodeDestination(std::string{target})};
+    if (!IsValidDestination(dest)) return std::nullopt;
+    return AddrIndex::ScriptHash(GetScriptForDestination(dest));
+}
+
+std::optional<UniValue> AddressHistoryToJSON(ChainstateManager& chainman, const AddrIndex& index, const uint256& script_hash, size_t skip, size_t count)
+{
+    // Look up one more entry to tell whether there is another page.
+    auto entries{index.FindScriptHistory(script_hash, skip, count + 1)};
+    if (!entries) return std::nullopt;
+    const bool more{entries->size() > count};
+    if (more) entries->pop_back();
+
+    UniValue history(UniValue::VARR);
+    {
+        LOCK(cs_main);
+        const CChain& active_chain{chainman.ActiveChain()};
+        for (const AddrIndexEntry& entry : *entries) {
+            UniValue obj(UniValue::VOBJ);
+            obj.pushKV("txid", entry.txid.GetHex());
+            obj.pushKV("height", entry.height);
+            // The block may have been disconnected since the lookup.
+            if (const CBlockIndex* block_index{active_chain[entry.height]}) {
+                obj.pushKV("blockhash", block_index->GetBlockHash().GetHex());
+            }
+            obj.pushKV("position", entry.tx_pos);
+            obj.pushKV(entry.spending ? "vin" : "vout", entry.index);
+            obj.pushKV("amount", ValueFromAmount(entry.amount));
+            if (!entry.spending) obj.pushKV("spent", entry.spent);
+            history.push_back(std::move(obj));
+        }
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("scripthash", script_hash.GetHex());
+    result.pushKV("history", std::move(history));
+    if (more) result.pushKV("next", uint64_t(skip + count));
+    return result;
+}
+
+static RPCHelpMan getaddresshistory()
+{
+    return RPCHelpMan{
+        "getaddresshistory",
+        "Return the confirmed transactions paying to or spending from an address, in chain order.\n"
+        "Requires the address index to be enabled (-addrindex). Each output paying to the address\n"
+        "and each input spending from it is a separate entry. Use skip and count to page through long histories.\n",
+        {
+            {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address, or the hex-encoded script hash (the reversed SHA256 of the output script, as used by Electrum servers)"},
+            {"skip", RPCArg::Type::NUM, RPCArg::Default{0}, "The number of entries to skip"},
+            {"count", RPCArg::Type::NUM, RPCArg::Default{int(DEFAULT_ADDRESS_HISTORY_RESULTS)}, strprintf("The maximum number of entries to return (1 to %d)", MAX_ADDRESS_HISTORY_RESULTS)},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::STR_HEX, "scripthash", "The script hash the history was looked up by"},
+                {RPCResult::Type::ARR, "history", "",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                        {RPCResult::Type::NUM, "height", "The height of the block containing the transaction"},
+                        {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "The hash of the block containing the transaction, if it is still in the active chain"},
+                        {RPCResult::Type::NUM, "position", "The position of the transaction in the block"},
+                        {RPCResult::Type::NUM, "vout", /*optional=*/true, "The index of the output paying to the address"},
+                        {RPCResult::Type::NUM, "vin", /*optional=*/true, "The index of the input spending from the address"},
+                        {RPCResult::Type::STR_AMOUNT, "amount", "The value of the output, or of the output spent by the input, in " + CURRENCY_UNIT},
+                        {RPCResult::Type::BOOL, "spent", /*optional=*/true, "For outputs, whether the output has been spent"},
+                    }},
+                }},
+                {RPCResult::Type::NUM, "next", /*optional=*/true, "The skip value for the next page, if there are more entries"},
+            }},
+        RPCExamples{
+            HelpExampleCli("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\"") +
+            HelpExampleCli("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\" 100 100") +
+            HelpExampleRpc("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\", 100, 100")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_addr_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled. Use -addrindex to enable it.");
+    }
+
+    const auto script_hash{ParseAddressHistoryTarget(self.Arg<std::string_view>("address"))};
+    if (!script_hash) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script hash");
+    }
+    const auto skip{self.Arg<int>("skip")};
+    if (skip < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    }
+    const auto count{self.Arg<int>("count")};
+    if (count < 1 || size_t(count) > MAX_ADDRESS_HISTORY_RESULTS) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 1 and %d", MAX_ADDRESS_HISTORY_RESULTS));
+    }
+
+    if (!g_addr_index->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to get data because addrindex is still syncing. Current height: %d", g_addr_index->GetSummary().best_block_height));
+    }
+
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    auto result{AddressHistoryToJSON(chainman, *g_addr_index, *script_hash, skip, count)};
+    if (!result) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the address index");
+    }
+    return std::move(*result);
+},
+    };
+}
+
 static RPCHelpMan getblockfilter()
 {
     return RPCHelpMan{
@@ -3494,6 +3685,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &scanblocks},
         {"blockchain", &getdescriptoractivity},
         {"blockchain", &getblockfilter},
+        {"blockchain", &getaddresshistory},
         {"blockchain", &dumptxoutset},
         {"blockchain", &loadtxoutset},
         {"blockchain", &getchainstates},
@@ -13,12 +13,17 @@
 #include <validation.h>
 
 #include <any>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <string_view>
 #include <vector>
 
+class AddrIndex;
 class CBlock;
 class CBlockIndex;
 class Chainstate;
+class JSONStreamWriter;
 class UniValue;
 namespace node {
 class BlockManager;
@@ -26,6 +31,9 @@ struct NodeContext;
 } // namespace node
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
+/** Default and maximum number of entries returned by one getaddresshistory call or REST request. */
+static constexpr size_t DEFAULT_ADDRESS_HISTORY_RESULTS{100};
+static constexpr size_t MAX_ADDRESS_HISTORY_RESULTS{1000};
 
 /**
  * Get the difficulty of the net wrt to the given block index.
@@ -37,6 +45,8 @@ double GetDifficulty(const CBlockIndex& blockindex);
 
 /** Block description to JSON */
 UniValue blockToJSON(node::BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity, const uint256 pow_limit) LOCKS_EXCLUDED(cs_main);
+/** Block description to JSON, streamed to out one transaction at a time */
+void blockToJSON(node::BlockManager& blockman, const CBlock& block, const CBlockIndex& tip, const CBlockIndex& blockindex, TxVerbosity verbosity, const uint256 pow_limit, JSONStreamWriter& out) LOCKS_EXCLUDED(cs_main);
 
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex& tip, const CBlockIndex& blockindex, const uint256 pow_limit) LOCKS_EXCLUDED(cs_main);
@@ -55,6 +65,15 @@ UniValue CreateUTXOSnapshot(
     const fs::path& path,
     const fs::path& tmppath);
 
+/** Parse an address, or the hex script hash of an output script, into the hash AddrIndex indexes by. */
+std::optional<uint256> ParseAddressHistoryTarget(std::string_view target);
+
+/**
+ * Address index history of a script to JSON, see getaddresshistory. Returns
+ * std::nullopt if the index could not be read.
+ */
+std::optional<UniValue> AddressHistoryToJSON(ChainstateManager& chainman, const AddrIndex& index, const uint256& script_hash, size_t skip, size_t count) LOCKS_EXCLUDED(cs_main);
+
 //! Return height of highest block that has been pruned, or std::nullopt if no blocks have been pruned
 std::optional<int> GetPruneHeight(const node::BlockManager& blockman, const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 void CheckBlockDataAvailability(node::BlockManager& blockman, const CBlockIndex& blockindex, bool check_for_undo) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
@@ -0,0 +1,100 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonstream.h>
+
+#include <util/check.h>
+
+#include <utility>
+
+JSONStreamWriter::JSONStreamWriter(Sink sink, size_t chunk_size)
+    : m_sink{std::move(sink)}, m_chunk_size{chunk_size}
+{
+    m_buffer.reserve(m_chunk_size);
+}
+
+void JSONStreamWriter::Write(std::string_view str)
+{
+    m_buffer.append(str);
+    if (m_capture) m_capture->append(str);
+    if (m_buffer.size() >= m_chunk_size) Flush();
+}
+
+void JSONStreamWriter::NextMember()
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (m_has_members.empty()) return;
+    if (m_has_members.back()) Write(",");
+    m_has_members.back() = true;
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    NextMember();
+    Write("{");
+    m_has_members.push_back(false);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    Assume(!m_has_members.empty() && !m_after_key);
+    m_has_members.pop_back();
+    Write("}");
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    NextMember();
+    Write("[");
+    m_has_members.push_back(false);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    Assume(!m_has_members.empty());
+    m_has_members.pop_back();
+    Write("]");
+}
+
+void JSONStreamWriter::Key(std::string_view key)
+{
+    Assume(!m_has_members.empty() && !m_after_key);
+    NextMember();
+    Write(UniValue{std::string{key}}.write());
+    Write(":");
+    m_after_key = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    NextMember();
+    Write(value.write());
+}
+
+void JSONStreamWriter::Members(const UniValue& obj)
+{
+    const auto& keys{obj.getKeys()};
+    const auto& values{obj.getValues()};
+    for (size_t i{0}; i < keys.size(); ++i) {
+        KeyValue(keys[i], values[i]);
+    }
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+    m_sink(m_buffer);
+    m_flushed += m_buffer.size();
+    m_buffer.clear();
+}
+
+std::string JSONStreamWriter::EndCapture()
+{
+    std::string captured{std::move(m_capture).value_or("")};
+    m_capture.reset();
+    return captured;
+}
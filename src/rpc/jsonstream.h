@@ -0,0 +1,81 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <univalue.h>
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Writer of a JSON value that hands its output to a sink in chunks while it
+ * is being written, so that large values never need to be held in memory as
+ * a whole, neither as a UniValue tree nor as a string.
+ *
+ * Objects and arrays are opened and closed explicitly, and their members are
+ * written one at a time, usually as small UniValue values. The output is the
+ * same as that of UniValue::write() without indentation for the same value.
+ */
+class JSONStreamWriter
+{
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    //! Size of the chunks handed to the sink.
+    static constexpr size_t DEFAULT_CHUNK_SIZE{64 << 10};
+
+    explicit JSONStreamWriter(Sink sink, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    //! Write the key of the next member of the current object.
+    void Key(std::string_view key);
+    //! Write a value, as a member of the current array or after Key().
+    void Value(const UniValue& value);
+    void KeyValue(std::string_view key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+    //! Write the members of the object obj into the current object.
+    void Members(const UniValue& obj);
+
+    //! Hand everything written so far to the sink.
+    void Flush();
+
+    //! Number of bytes written, including those not yet handed to the sink.
+    size_t BytesWritten() const { return m_flushed + m_buffer.size(); }
+    //! Whether any output has been handed to the sink yet.
+    bool Flushed() const { return m_flushed > 0; }
+
+    //! Additionally keep a copy of everything written from now on.
+    void StartCapture() { m_capture.emplace(); }
+    //! Stop keeping a copy of the output and return what was kept.
+    std::string EndCapture();
+
+private:
+    const Sink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    size_t m_flushed{0};
+    std::optional<std::string> m_capture;
+    //! For each open object or array, whether it has members yet.
+    std::vector<bool> m_has_members;
+    //! Whether a key was written that still needs its value.
+    bool m_after_key{false};
+
+    void Write(std::string_view str);
+    //! Separate the next member from the previous one.
+    void NextMember();
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
@@ -10,6 +10,7 @@
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <index/txospenderindex.h>
 #include <kernel/mempool_entry.h>
 #include <net_processing.h>
 #include <node/mempool_persist_args.h>
@@ -17,6 +18,7 @@
 #include <policy/rbf.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -300,17 +302,19 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("weight", (int)e.GetTxWeight());
     info.pushKV("time", count_seconds(e.GetTime()));
     info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
+    const auto [descendant_count, descendant_size, descendant_fees] = pool.CalculateDescendantData(e);
+    const auto [ancestor_count, ancestor_size, ancestor_fees] = pool.CalculateAncestorData(e);
+    info.pushKV("descendantcount", descendant_count);
+    info.pushKV("descendantsize", descendant_size);
+    info.pushKV("ancestorcount", ancestor_count);
+    info.pushKV("ancestorsize", ancestor_size);
     info.pushKV("wtxid", e.GetTx().GetWitnessHash().ToString());
 
     UniValue fees(UniValue::VOBJ);
     fees.pushKV("base", ValueFromAmount(e.GetFee()));
     fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("ancestor", ValueFromAmount(ancestor_fees));
+    fees.pushKV("descendant", ValueFromAmount(descendant_fees));
     info.pushKV("fees", std::move(fees));
 
     const CTransaction& tx = e.GetTx();
@@ -387,6 +391,18 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
     }
 }
 
+void MempoolToJSON(const CTxMemPool& pool, JSONStreamWriter& out)
+{
+    LOCK(pool.cs);
+    out.BeginObject();
+    for (const CTxMemPoolEntry& e : pool.entryAll()) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(pool, info, e);
+        out.KeyValue(e.GetTx().GetHash().ToString(), info);
+    }
+    out.EndObject();
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{
@@ -433,6 +449,11 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
+    if (fVerbose && !include_mempool_sequence && request.m_result_stream) {
+        MempoolToJSON(EnsureAnyMemPool(request.context), *request.m_result_stream);
+        return UniValue{};
+    }
+
     return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose, include_mempool_sequence);
 },
     };
@@ -477,7 +498,7 @@ static RPCHelpMan getmempoolancestors()
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
     }
 
-    auto ancestors{mempool.AssumeCalculateMemPoolAncestors(self.m_name, *entry, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
+    const auto ancestors{mempool.GetAncestors(*entry)};
 
     if (!fVerbose) {
         UniValue o(UniValue::VARR);
@@ -600,7 +621,8 @@ static RPCHelpMan getmempoolentry()
 static RPCHelpMan gettxspendingprevout()
 {
     return RPCHelpMan{"gettxspendingprevout",
-        "Scans the mempool to find transactions spending any of the given outputs",
+        "Scans the mempool to find transactions spending any of the given outputs.\n"
+        "If the spent output index is enabled (-txospenderindex), outputs spent in the active chain are looked up in it as well.",
         {
             {"outputs", RPCArg::Type::ARR, RPCArg::Optional::NO, "The transaction outputs that we want to check, and within each, the txid (string) vout (numeric).",
                 {
@@ -620,7 +642,10 @@ static RPCHelpMan gettxspendingprevout()
                 {
                     {RPCResult::Type::STR_HEX, "txid", "the transaction id of the checked output"},
                     {RPCResult::Type::NUM, "vout", "the vout value of the checked output"},
-                    {RPCResult::Type::STR_HEX, "spendingtxid", /*optional=*/true, "the transaction id of the mempool transaction spending this output (omitted if unspent)"},
+                    {RPCResult::Type::STR_HEX, "spendingtxid", /*optional=*/true, "the transaction id of the mempool or confirmed transaction spending this output (omitted if unspent)"},
+                    {RPCResult::Type::NUM, "vin", /*optional=*/true, "the index of the input spending this output (only for confirmed spends)"},
+                    {RPCResult::Type::NUM, "height", /*optional=*/true, "the height of the block containing the spending transaction (only for confirmed spends)"},
+                    {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "the hash of the block containing the spending transaction (only for confirmed spends)"},
                 }},
             }
         },
@@ -657,18 +682,44 @@ static RPCHelpMan gettxspendingprevout()
             }
 
             const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-            LOCK(mempool.cs);
+            std::vector<std::optional<Txid>> mempool_spenders;
+            mempool_spenders.reserve(prevouts.size());
+            {
+                LOCK(mempool.cs);
+                for (const COutPoint& prevout : prevouts) {
+                    const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
+                    mempool_spenders.push_back(spendingTx ? std::optional{spendingTx->GetHash()} : std::nullopt);
+                }
+            }
 
+            std::vector<std::optional<TxoSpender>> chain_spenders(prevouts.size());
+            if (g_txospenderindex) {
+                if (!g_txospenderindex->BlockUntilSyncedToCurrentChain()) {
+                    throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to get data because txospenderindex is still syncing. Current height: %d", g_txospenderindex->GetSummary().best_block_height));
+                }
+                chain_spenders = g_txospenderindex->FindSpenders(prevouts);
+            }
+
+            ChainstateManager& chainman = EnsureAnyChainman(request.context);
+            LOCK(cs_main);
             UniValue result{UniValue::VARR};
 
-            for (const COutPoint& prevout : prevouts) {
+            for (size_t i = 0; i < prevouts.size(); ++i) {
+                const COutPoint& prevout{prevouts[i]};
                 UniValue o(UniValue::VOBJ);
                 o.pushKV("txid", prevout.hash.ToString());
                 o.pushKV("vout", (uint64_t)prevout.n);
 
-                const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
-                if (spendingTx != nullptr) {
-                    o.pushKV("spendingtxid", spendingTx->GetHash().ToString());
+                if (mempool_spenders[i]) {
+                    o.pushKV("spendingtxid", mempool_spenders[i]->ToString());
+                } else if (const auto& spender{chain_spenders[i]}) {
+                    o.pushKV("spendingtxid", spender->txid.ToString());
+                    o.pushKV("vin", spender->vin);
+                    o.pushKV("height", spender->height);
+                    // The block may have been disconnected since the lookup.
+                    if (const CBlockIndex* block_index{chainman.ActiveChain()[spender->height]}) {
+                        o.pushKV("blockhash", block_index->GetBlockHash().GetHex());
+                    }
                 }
 
                 result.push_back(std::move(o));
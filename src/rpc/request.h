@@ -13,6 +13,8 @@
 #include <univalue.h>
 #include <util/fs.h>
 
+class JSONStreamWriter;
+
 enum class JSONRPCVersion {
     V1_LEGACY,
     V2
@@ -61,6 +63,13 @@ public:
     std::string peerAddr;
     std::any context;
     JSONRPCVersion m_json_version = JSONRPCVersion::V1_LEGACY;
+    /**
+     * Where the result may be streamed to, if the transport supports it.
+     * Methods returning large results may write them there instead of
+     * returning them, and then return null. Whether they did shows in the
+     * bytes written to the stream.
+     */
+    JSONStreamWriter* m_result_stream{nullptr};
 
     void parse(const UniValue& valRequest);
     [[nodiscard]] bool IsNotification() const { return !id.has_value() && m_json_version == JSONRPCVersion::V2; };
@@ -12,6 +12,7 @@
 #include <node/types.h>
 #include <outputtype.h>
 #include <pow.h>
+#include <rpc/jsonstream.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
 #include <script/interpreter.h>
@@ -655,11 +656,18 @@ UniValue RPCHelpMan::HandleRequest(const JSONRPCRequest& request) const
     if (!arg_mismatch.empty()) {
         throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Wrong type passed:\n%s", arg_mismatch.write(4)));
     }
+    const bool check_result{gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)};
+    // Keep a copy of a streamed result to check it
+    if (check_result && request.m_result_stream) request.m_result_stream->StartCapture();
     CHECK_NONFATAL(m_req == nullptr);
     m_req = &request;
     UniValue ret = m_fun(*this, request);
     m_req = nullptr;
-    if (gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
+    if (check_result) {
+        if (request.m_result_stream) {
+            const std::string streamed{request.m_result_stream->EndCapture()};
+            if (!streamed.empty()) CHECK_NONFATAL(ret.read(streamed));
+        }
         UniValue mismatch{UniValue::VARR};
         for (const auto& res : m_results.m_results) {
             UniValue match{res.MatchesType(ret)};
@@ -121,6 +121,52 @@ public:
     }
 };
 
+/** Like SpanReader, for data obfuscated with the given key, starting at
+ * key_offset. Bytes are deobfuscated as they are read, so that the data does
+ * not have to be copied out first.
+ */
+class ObfuscatedSpanReader
+{
+private:
+    std::span<const std::byte> m_data;
+    const Obfuscation& m_obfuscation;
+    size_t m_key_offset;
+
+public:
+    explicit ObfuscatedSpanReader(std::span<const std::byte> data, const Obfuscation& obfuscation LIFETIMEBOUND, size_t key_offset)
+        : m_data{data}, m_obfuscation{obfuscation}, m_key_offset{key_offset} {}
+
+    template<typename T>
+    ObfuscatedSpanReader& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+
+    size_t size() const { return m_data.size(); }
+    bool empty() const { return m_data.empty(); }
+
+    void read(std::span<std::byte> dst)
+    {
+        if (dst.size() == 0) {
+            return;
+        }
+        if (dst.size() > m_data.size()) {
+            throw std::ios_base::failure("ObfuscatedSpanReader::read(): end of data");
+        }
+        memcpy(dst.data(), m_data.data(), dst.size());
+        m_obfuscation(dst, m_key_offset);
+        m_data = m_data.subspan(dst.size());
+        m_key_offset += dst.size();
+    }
+
+    void ignore(size_t n)
+    {
+        m_data = m_data.subspan(n);
+        m_key_offset += n;
+    }
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
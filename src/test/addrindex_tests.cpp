@@ -0,0 +1,101 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/addrindex.h>
+#include <interfaces/chain.h>
+#include <key.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addrindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(addrindex_initial_sync_and_reorg, TestChain100Setup)
+{
+    AddrIndex addr_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(addr_index.Init());
+
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const uint256 coinbase_hash{AddrIndex::ScriptHash(coinbase_script)};
+
+    // Nothing is found before the index is started.
+    BOOST_CHECK(addr_index.FindScriptHistory(coinbase_hash, 0, 1000)->empty());
+
+    addr_index.Sync();
+
+    // Every block of the test chain pays to the coinbase script.
+    auto history{addr_index.FindScriptHistory(coinbase_hash, 0, 1000)};
+    BOOST_REQUIRE(history);
+    BOOST_REQUIRE_EQUAL(history->size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < history->size(); ++i) {
+        const AddrIndexEntry& entry{(*history)[i]};
+        BOOST_CHECK_EQUAL(entry.height, int(i + 1));
+        BOOST_CHECK_EQUAL(entry.tx_pos, 0U);
+        BOOST_CHECK(entry.txid == m_coinbase_txns[i]->GetHash());
+        BOOST_CHECK(!entry.spending);
+        BOOST_CHECK_EQUAL(entry.index, 0U);
+        BOOST_CHECK_EQUAL(entry.amount, m_coinbase_txns[i]->vout[0].nValue);
+        BOOST_CHECK(!entry.spent);
+    }
+
+    // Pages continue where the previous one stopped.
+    const auto page{addr_index.FindScriptHistory(coinbase_hash, 40, 10)};
+    BOOST_REQUIRE_EQUAL(page->size(), 10U);
+    BOOST_CHECK_EQUAL(page->front().height, 41);
+    BOOST_CHECK(addr_index.FindScriptHistory(coinbase_hash, m_coinbase_txns.size(), 10)->empty());
+
+    // Spend the first coinbase output to a new key, and that output again in
+    // the same block.
+    CKey key{GenerateRandomKey()};
+    const CScript script{GetScriptForDestination(WitnessV0KeyHash(key.GetPubKey()))};
+    const uint256 script_hash{AddrIndex::ScriptHash(script)};
+    CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script, 10 * COIN, /*submit=*/false)};
+    CMutableTransaction respend{CreateValidMempoolTransaction(MakeTransactionRef(spend), 0, 101, key, script, 9 * COIN, /*submit=*/false)};
+    const CBlock block{CreateAndProcessBlock({spend, respend}, coinbase_script)};
+    BOOST_REQUIRE(addr_index.BlockUntilSyncedToCurrentChain());
+
+    history = addr_index.FindScriptHistory(coinbase_hash, 0, 1000);
+    BOOST_REQUIRE_EQUAL(history->size(), m_coinbase_txns.size() + 2);
+    BOOST_CHECK(history->front().spent);
+    BOOST_CHECK(!history->at(1).spent);
+    // The new block's coinbase output, and the input spending the first coinbase.
+    BOOST_CHECK(!history->at(history->size() - 2).spending);
+    BOOST_CHECK_EQUAL(history->at(history->size() - 2).tx_pos, 0U);
+    const AddrIndexEntry& input{history->back()};
+    BOOST_CHECK(input.spending);
+    BOOST_CHECK_EQUAL(input.height, 101);
+    BOOST_CHECK_EQUAL(input.tx_pos, 1U);
+    BOOST_CHECK(input.txid == spend.GetHash());
+    BOOST_CHECK_EQUAL(input.amount, m_coinbase_txns[0]->vout[0].nValue);
+
+    history = addr_index.FindScriptHistory(script_hash, 0, 1000);
+    BOOST_REQUIRE_EQUAL(history->size(), 3U);
+    BOOST_CHECK(!history->at(0).spending && history->at(0).spent && history->at(0).txid == spend.GetHash());
+    BOOST_CHECK(!history->at(1).spending && !history->at(1).spent && history->at(1).txid == respend.GetHash());
+    BOOST_CHECK(history->at(2).spending && history->at(2).txid == respend.GetHash());
+
+    // Replace the block by one without the spends.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    CreateAndProcessBlock({}, coinbase_script);
+    BOOST_REQUIRE(addr_index.BlockUntilSyncedToCurrentChain());
+
+    history = addr_index.FindScriptHistory(coinbase_hash, 0, 1000);
+    BOOST_REQUIRE_EQUAL(history->size(), m_coinbase_txns.size() + 1);
+    BOOST_CHECK(!history->front().spent);
+    BOOST_CHECK(!history->back().spending);
+    BOOST_CHECK(addr_index.FindScriptHistory(script_hash, 0, 1000)->empty());
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    addr_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,8 @@
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <index/blockfilterindex.h>
+#include <index/blockreader.h>
+#include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <node/miner.h>
 #include <pow.h>
@@ -383,4 +385,42 @@ BOOST_FIXTURE_TEST_CASE(index_reorg_crash, BuildChainTestingSetup)
     index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(shared_block_reads, BuildChainTestingSetup)
+{
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, true);
+    BOOST_REQUIRE(txindex.Init());
+    BOOST_REQUIRE(filter_index.Init());
+
+    IndexBlockReader block_reader{m_node.chainman->m_blockman};
+    txindex.ShareBlockReads(block_reader);
+    filter_index.ShareBlockReads(block_reader);
+    BOOST_REQUIRE(txindex.StartBackgroundSync());
+    BOOST_REQUIRE(filter_index.StartBackgroundSync());
+
+    const auto deadline{std::chrono::steady_clock::now() + 30s};
+    while (!txindex.GetSummary().synced || !filter_index.GetSummary().synced) {
+        BOOST_REQUIRE(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(10ms);
+    }
+
+    // Both indexes were built from a single read of each block.
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_CHECK_EQUAL(block_reader.GetBlocksRead(), uint64_t(tip->nHeight + 1));
+
+    uint256 last_header;
+    for (const CBlockIndex* block_index{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Genesis())}; block_index;
+         block_index = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Next(block_index))) {
+        CheckFilterLookups(filter_index, block_index, last_header, m_node.chainman->m_blockman);
+    }
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    txindex.Stop();
+    filter_index.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
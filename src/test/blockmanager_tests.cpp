@@ -11,6 +11,7 @@
 #include <script/solver.h>
 #include <primitives/block.h>
 #include <util/chaintype.h>
+#include <util/mappedfile.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
@@ -223,4 +224,69 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_read_mapped_block)
+{
+    KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+    for (const bool mmap_blocks : {true, false}) {
+        const BlockManager::Options blockman_opts{
+            .chainparams = Params(),
+            .mmap_blocks = mmap_blocks,
+            .fast_prune = true,
+            .blocks_dir = m_args.GetBlocksDirPath(),
+            .notifications = notifications,
+            .block_tree_db_params = DBParams{
+                .path = m_args.GetDataDirNet() / "blocks" / "index",
+                .cache_bytes = 0,
+                .memory_only = true,
+            },
+        };
+        BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+        const CBlock& genesis{Params().GenesisBlock()};
+        DataStream expected;
+        expected << TX_WITH_WITNESS(genesis);
+
+        // Fill the first small -fastprune block file, so it is finalized.
+        std::vector<FlatFilePos> positions;
+        do {
+            positions.push_back(blockman.WriteBlock(genesis, /*nHeight=*/1));
+        } while (positions.back().nFile == positions.front().nFile);
+        const int first_file{positions.front().nFile};
+        const size_t expected_mapped{mmap_blocks && MappedFile::SUPPORTED && node::MAX_MAPPED_BLOCKFILES > 0 ? 1U : 0U};
+
+        for (const auto& pos : positions) {
+            CBlock block;
+            BOOST_CHECK(blockman.ReadBlock(block, pos, genesis.GetHash()));
+            std::vector<std::byte> raw;
+            BOOST_CHECK(blockman.ReadRawBlock(raw, pos));
+            BOOST_CHECK(std::ranges::equal(raw, expected));
+            // Only the finalized file is mapped, the one being written to is not.
+            BOOST_CHECK_EQUAL(blockman.MappedBlockFileCount(), expected_mapped);
+        }
+
+        // Positions without a valid block header are rejected.
+        std::vector<std::byte> raw;
+        {
+            ASSERT_DEBUG_LOG("Block magic mismatch");
+            BOOST_CHECK(!blockman.ReadRawBlock(raw, FlatFilePos{first_file, positions.front().nPos + 1}));
+        }
+
+        // A mapping of a file that was truncated is not read from anymore.
+        // The file is mapped again at its new size, and blocks past its end
+        // can't be read.
+        const FlatFilePos last_pos{positions[positions.size() - 2]};
+        fs::resize_file(blockman.GetBlockPosFilename(last_pos), last_pos.nPos);
+        CBlock block;
+        {
+            std::optional<DebugLogHelper> shrunk_log;
+            if (expected_mapped) shrunk_log.emplace("shrunk while mapped");
+            BOOST_CHECK(blockman.ReadBlock(block, positions.front(), genesis.GetHash()));
+        }
+        BOOST_CHECK_EQUAL(blockman.MappedBlockFileCount(), expected_mapped);
+        BOOST_CHECK(!blockman.ReadBlock(block, last_pos, genesis.GetHash()));
+
+        blockman.UnlinkPrunedFiles({first_file, positions.back().nFile});
+        BOOST_CHECK_EQUAL(blockman.MappedBlockFileCount(), 0U);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <addresstype.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -42,4 +43,44 @@ BOOST_FIXTURE_TEST_CASE(chainstate_write_interval, TestingSetup)
     BOOST_CHECK(sub->m_did_flush);
 }
 
+BOOST_FIXTURE_TEST_CASE(chainstate_write_incremental, TestChain100Setup)
+{
+    auto& chainman{*Assert(m_node.chainman)};
+    auto& chainstate{chainman.ActiveChainstate()};
+    BlockValidationState state;
+    WITH_LOCK(::cs_main, chainstate.ForceFlushStateToDisk());
+
+    // Spending a coinbase output that is on disk queues it for an incremental flush.
+    const CBlock block{CreateAndProcessBlock({CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, GetScriptForDestination(PKHash(coinbaseKey.GetPubKey())), CAmount{49 * COIN}, /*submit=*/false)}, CScript{} << OP_TRUE)};
+    const COutPoint spent{m_coinbase_txns[0]->GetHash(), 0};
+    const size_t queued{WITH_LOCK(::cs_main, return chainstate.CoinsTip().GetPartialSyncQueueSize())};
+    BOOST_CHECK_GT(queued, 0U);
+    BOOST_CHECK(WITH_LOCK(::cs_main, return chainstate.CoinsDB().HaveCoin(spent)));
+
+    // Blockers hold incremental flushes off.
+    {
+        const IncrementalFlushBlocker blocker{chainstate};
+        BOOST_CHECK(chainstate.FlushCoinsIncrementally(state));
+        BOOST_CHECK(!WITH_LOCK(::cs_main, return chainstate.CoinsDB().IsPartiallyWritten()));
+    }
+
+    BOOST_CHECK(chainstate.FlushCoinsIncrementally(state));
+    LOCK(::cs_main);
+    BOOST_CHECK_EQUAL(chainstate.CoinsTip().GetPartialSyncQueueSize(), 0U);
+    BOOST_CHECK_EQUAL(chainstate.CoinsPrefetch().GetPendingCount(), 0U);
+    BOOST_CHECK(!chainstate.CoinsDB().HaveCoin(spent));
+    BOOST_CHECK(chainstate.CoinsDB().IsPartiallyWritten());
+    BOOST_CHECK(chainstate.CoinsDB().GetHeadBlocks()[0] == block.GetHash());
+    BOOST_CHECK_EQUAL(chainstate.GetCoinsFlushStats().incremental_coins, queued);
+
+    // Disconnecting the block makes the database consistent with it first.
+    {
+        LOCK(Assert(m_node.mempool)->cs);
+        BOOST_CHECK(chainstate.DisconnectTip(state, /*disconnectpool=*/nullptr));
+    }
+    BOOST_CHECK(!chainstate.CoinsDB().IsPartiallyWritten());
+    BOOST_CHECK(chainstate.CoinsDB().GetBestBlock() == block.GetHash());
+    BOOST_CHECK(chainstate.CoinsTip().HaveCoin(spent));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -34,13 +34,13 @@ struct NoLockLoggingTestingSetup : public TestingSetup {
 #endif
 };
 
-struct CheckQueueTest : NoLockLoggingTestingSetup {
-    void Correct_Queue_range(std::vector<size_t> range);
-};
-
 static const unsigned int QUEUE_BATCH_SIZE = 128;
 static const int SCRIPT_CHECK_THREADS = 3;
 
+struct CheckQueueTest : NoLockLoggingTestingSetup {
+    void Correct_Queue_range(std::vector<size_t> range, int worker_threads_num = SCRIPT_CHECK_THREADS);
+};
+
 struct FakeCheck {
     std::optional<int> operator()() const
     {
@@ -156,9 +156,9 @@ typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
-void CheckQueueTest::Correct_Queue_range(std::vector<size_t> range)
+void CheckQueueTest::Correct_Queue_range(std::vector<size_t> range, int worker_threads_num)
 {
-    auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS);
+    auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE, worker_threads_num);
     // Make vChecks here to save on malloc (this test can be slow...)
     std::vector<FakeCheckCheckCompletion> vChecks;
     vChecks.reserve(9);
@@ -213,6 +213,12 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_Random)
         range.push_back(i);
     Correct_Queue_range(range);
 }
+/** Test that checks spread over more queues than there are cores are all run
+ */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_Many_Threads)
+{
+    Correct_Queue_range({1, 2, 63, 64, 65, 1000, 100000}, /*worker_threads_num=*/63);
+}
 
 
 /** Test that distinct failing checks are caught */
@@ -84,7 +84,7 @@ public:
     void SelfTest(bool sanity_check = true) const
     {
         // Manually recompute the dynamic usage of the whole data, and compare it.
-        size_t ret = memusage::DynamicUsage(cacheCoins);
+        size_t ret = memusage::DynamicUsage(cacheCoins) + memusage::DynamicUsage(m_partial_sync_queue);
         size_t count = 0;
         for (const auto& entry : cacheCoins) {
             ret += entry.second.coin.DynamicMemoryUsage();
@@ -1121,4 +1121,184 @@ BOOST_AUTO_TEST_CASE(ccoins_emplace_duplicate_keeps_usage_balanced)
     BOOST_CHECK(cache.AccessCoin(outpoint) == coin1);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewPrefetch prefetch{&base};
+    CCoinsViewCacheTest cache{&prefetch};
+
+    const COutPoint present{Txid::FromUint256(m_rng.rand256()), 0};
+    const COutPoint missing{Txid::FromUint256(m_rng.rand256()), 0};
+    const Coin coin{CTxOut{m_rng.randrange(10), CScript{} << m_rng.randbytes(10)}, 1, false};
+    cache.AddCoin(present, Coin{coin}, /*possible_overwrite=*/false);
+    cache.SetBestBlock(m_rng.rand256());
+    BOOST_CHECK(cache.Flush());
+
+    // Only coins found in the backing view are staged, and each is handed out once.
+    const std::vector<COutPoint> outpoints{present, missing};
+    prefetch.Prefetch(outpoints);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 1U);
+    BOOST_CHECK(cache.AccessCoin(present) == coin);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 0U);
+
+    // Writing through the prefetch view drops staged coins, so that a coin
+    // spent by the write is not served from the staging area afterwards.
+    prefetch.Prefetch(outpoints);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 1U);
+    BOOST_CHECK(cache.SpendCoin(present));
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 0U);
+    BOOST_CHECK(!prefetch.GetCoin(present));
+    BOOST_CHECK(!cache.HaveCoin(present));
+
+    prefetch.Prefetch(outpoints);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 0U);
+
+    const auto stats{prefetch.GetStats()};
+    BOOST_CHECK_EQUAL(stats.lookups, 6U);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.wasted, 5U);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_prefetch_partial_write)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewPrefetch prefetch{&base};
+    CCoinsViewCacheTest cache{&prefetch};
+    cache.EnablePartialSync(/*max_queued=*/10);
+
+    const COutPoint spent{Txid::FromUint256(m_rng.rand256()), 0};
+    const COutPoint kept{Txid::FromUint256(m_rng.rand256()), 0};
+    const Coin coin{CTxOut{m_rng.randrange(10), CScript{} << m_rng.randbytes(10)}, 1, false};
+    cache.AddCoin(spent, Coin{coin}, /*possible_overwrite=*/false);
+    cache.AddCoin(kept, Coin{coin}, /*possible_overwrite=*/false);
+    const uint256 old_tip{m_rng.rand256()};
+    cache.SetBestBlock(old_tip);
+    BOOST_CHECK(cache.Flush());
+
+    const std::vector<COutPoint> outpoints{spent, kept};
+    prefetch.Prefetch(outpoints);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 2U);
+    // Spend the coin through the cache without touching the staged copy.
+    cache.EmplaceCoinInternalDANGER(COutPoint{spent}, Coin{coin});
+    BOOST_CHECK(cache.SpendCoin(spent));
+    const uint256 new_tip{m_rng.rand256()};
+    cache.SetBestBlock(new_tip);
+
+    // A partial write is held back, and only drops the staged coin it overwrites.
+    BOOST_CHECK_EQUAL(*cache.SyncPartial(10), 1U);
+    BOOST_CHECK_EQUAL(prefetch.GetPendingCount(), 1U);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 1U);
+    BOOST_CHECK(base.HaveCoin(spent));
+    BOOST_CHECK(!base.IsPartiallyWritten());
+    BOOST_CHECK(!prefetch.GetCoin(spent));
+    BOOST_CHECK(!cache.HaveCoin(spent));
+
+    // Lookups of pending coins are not staged from the stale database.
+    prefetch.Prefetch(outpoints);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 1U);
+
+    BOOST_CHECK(prefetch.WritePending());
+    BOOST_CHECK_EQUAL(prefetch.GetPendingCount(), 0U);
+    BOOST_CHECK_EQUAL(prefetch.GetStagedCount(), 1U);
+    BOOST_CHECK(!base.HaveCoin(spent));
+    BOOST_CHECK(base.IsPartiallyWritten());
+    BOOST_CHECK(base.GetHeadBlocks() == std::vector<uint256>({new_tip, old_tip}));
+    BOOST_CHECK(cache.AccessCoin(kept) == coin);
+    BOOST_CHECK_EQUAL(prefetch.GetStats().hits, 1U);
+
+    // Coins still pending are written ahead of a full write.
+    cache.EmplaceCoinInternalDANGER(COutPoint{kept}, Coin{coin});
+    BOOST_CHECK(cache.SpendCoin(kept));
+    BOOST_CHECK_EQUAL(*cache.SyncPartial(10), 1U);
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK_EQUAL(prefetch.GetPendingCount(), 0U);
+    BOOST_CHECK(!base.HaveCoin(kept));
+    BOOST_CHECK(!base.IsPartiallyWritten());
+    BOOST_CHECK(base.GetBestBlock() == new_tip);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sync_partial)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCacheTest cache{&base};
+    cache.EnablePartialSync(/*max_queued=*/3);
+
+    std::vector<COutPoint> outpoints;
+    for (int i{0}; i < 5; ++i) {
+        outpoints.emplace_back(Txid::FromUint256(m_rng.rand256()), 0);
+        cache.AddCoin(outpoints.back(), Coin{CTxOut{i + 1, CScript{} << OP_TRUE}, 1, false}, /*possible_overwrite=*/false);
+    }
+    const uint256 old_tip{m_rng.rand256()};
+    cache.SetBestBlock(old_tip);
+    // FRESH coins are left for a full flush.
+    BOOST_CHECK_EQUAL(cache.GetPartialSyncQueueSize(), 0U);
+    BOOST_CHECK(cache.Flush());
+
+    // Spending coins the database has queues them, up to the limit.
+    for (const auto& outpoint : outpoints) BOOST_CHECK(cache.SpendCoin(outpoint));
+    BOOST_CHECK_EQUAL(cache.GetPartialSyncQueueSize(), 3U);
+    const COutPoint added{Txid::FromUint256(m_rng.rand256()), 0};
+    cache.AddCoin(added, Coin{CTxOut{1, CScript{} << OP_TRUE}, 2, false}, /*possible_overwrite=*/false);
+    const uint256 new_tip{m_rng.rand256()};
+    cache.SetBestBlock(new_tip);
+
+    BOOST_CHECK_EQUAL(*cache.SyncPartial(2), 2U);
+    BOOST_CHECK_EQUAL(cache.GetPartialSyncQueueSize(), 1U);
+    BOOST_CHECK(!base.HaveCoin(outpoints[0]));
+    BOOST_CHECK(!base.HaveCoin(outpoints[1]));
+    BOOST_CHECK(base.HaveCoin(outpoints[2]));
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoints[0]));
+    cache.SelfTest();
+
+    // The database is marked as being in transition from the old tip.
+    BOOST_CHECK(base.IsPartiallyWritten());
+    BOOST_CHECK(base.GetBestBlock().IsNull());
+    BOOST_CHECK(base.GetHeadBlocks() == std::vector<uint256>({new_tip, old_tip}));
+
+    // Further partial writes keep the old tip as the point to recover from.
+    const uint256 newer_tip{m_rng.rand256()};
+    cache.SetBestBlock(newer_tip);
+    BOOST_CHECK_EQUAL(*cache.SyncPartial(10), 1U);
+    BOOST_CHECK(base.GetHeadBlocks() == std::vector<uint256>({newer_tip, old_tip}));
+    BOOST_CHECK_EQUAL(*cache.SyncPartial(10), 0U);
+
+    // A full write makes the database consistent again.
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(!base.IsPartiallyWritten());
+    BOOST_CHECK(base.GetBestBlock() == newer_tip);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    for (const auto& outpoint : outpoints) BOOST_CHECK(!base.HaveCoin(outpoint));
+    BOOST_CHECK(base.HaveCoin(added));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_db_getcoins)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCacheTest cache{&base};
+
+    std::vector<COutPoint> outpoints;
+    for (int i{0}; i < 100; ++i) {
+        const COutPoint outpoint{Txid::FromUint256(m_rng.rand256()), uint32_t(i)};
+        outpoints.push_back(outpoint);
+        // Leave every third outpoint out of the database.
+        if (i % 3 == 0) continue;
+        cache.AddCoin(outpoint, Coin{CTxOut{i, CScript{} << m_rng.randbytes(10)}, i, false}, /*possible_overwrite=*/false);
+    }
+    cache.SetBestBlock(m_rng.rand256());
+    BOOST_CHECK(cache.Flush());
+    // Duplicates are answered individually.
+    outpoints.push_back(outpoints[1]);
+
+    const auto coins{base.GetCoins(outpoints)};
+    BOOST_REQUIRE_EQUAL(coins.size(), outpoints.size());
+    for (size_t i{0}; i < outpoints.size(); ++i) {
+        const auto coin{base.GetCoin(outpoints[i])};
+        BOOST_REQUIRE_EQUAL(coins[i].has_value(), coin.has_value());
+        if (coin) BOOST_CHECK(*coins[i] == *coin);
+    }
+    BOOST_CHECK(!coins[0]);
+    BOOST_CHECK(coins[1] && coins.back() && *coins[1] == *coins.back());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,9 +7,12 @@
 #include <test/util/setup_common.h>
 #include <uint256.h>
 #include <util/string.h>
+#include <util/threadpool.h>
 
+#include <future>
 #include <memory>
 #include <ranges>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -185,6 +188,78 @@ BOOST_AUTO_TEST_CASE(dbwrapper_batch)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_read_many)
+{
+    ThreadPool pool{"dbreadmany"};
+    pool.Start(3);
+    // Perform tests both obfuscated and non-obfuscated.
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = m_args.GetDataDirBase() / (obfuscate ? "dbwrapper_read_many_obfuscate_true" : "dbwrapper_read_many_obfuscate_false");
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate});
+
+        // Write every other key, and query them in an order unrelated to
+        // the key order so results have to be mapped back.
+        constexpr uint32_t NUM_KEYS{1000};
+        std::vector<uint256> values(NUM_KEYS);
+        CDBBatch batch(dbw);
+        for (uint32_t i{0}; i < NUM_KEYS; i += 2) {
+            values[i] = m_rng.rand256();
+            batch.Write(std::make_pair(uint8_t{'r'}, i), values[i]);
+        }
+        dbw.WriteBatch(batch);
+        std::vector<std::pair<uint8_t, uint32_t>> keys;
+        for (uint32_t i{0}; i < NUM_KEYS; ++i) keys.emplace_back('r', (i * 7919) % NUM_KEYS);
+
+        for (ThreadPool* p : {static_cast<ThreadPool*>(nullptr), &pool}) {
+            const auto res{dbw.ReadMany<uint256>(std::span{std::as_const(keys)}, p)};
+            BOOST_REQUIRE_EQUAL(res.size(), keys.size());
+            for (size_t i{0}; i < keys.size(); ++i) {
+                const uint32_t n{keys[i].second};
+                if (n % 2 == 0) {
+                    BOOST_REQUIRE(res[i].has_value());
+                    BOOST_CHECK_EQUAL(*res[i], values[n]);
+                } else {
+                    BOOST_CHECK(!res[i].has_value());
+                }
+            }
+        }
+
+        // Reading from all workers of the pool at once can't deadlock, as
+        // ranges no worker has picked up are read by the caller.
+        std::vector<std::future<size_t>> nested;
+        for (size_t i{0}; i < pool.WorkersCount(); ++i) {
+            nested.emplace_back(pool.Submit([&] { return dbw.ReadMany<uint256>(std::span{std::as_const(keys)}, &pool).size(); }));
+        }
+        for (auto& future : nested) BOOST_CHECK_EQUAL(future.get(), keys.size());
+
+        // A value that fails to deserialize is reported as missing.
+        dbw.Write(std::make_pair(uint8_t{'r'}, uint32_t{1}), uint8_t{0});
+        const std::vector<std::pair<uint8_t, uint32_t>> short_keys{{'r', 1}, {'r', 0}};
+        const auto res{dbw.ReadMany<uint256>(std::span{short_keys})};
+        BOOST_CHECK(!res[0].has_value());
+        BOOST_CHECK(res[1].has_value());
+        BOOST_CHECK(dbw.ReadMany<uint256>(std::span<const uint8_t>{}).empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_read_many_snapshot)
+{
+    CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_read_many_snapshot", .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = true});
+    const std::vector<uint8_t> keys{'a', 'b', 'c'};
+    dbw.Write(keys[0], uint32_t{1});
+    dbw.Write(keys[1], uint32_t{2});
+    const auto snapshot{dbw.GetSnapshot()};
+
+    // Writes made after the snapshot was taken are not visible through it.
+    dbw.Write(keys[1], uint32_t{20});
+    dbw.Erase(keys[0]);
+    dbw.Write(keys[2], uint32_t{30});
+    const auto old_values{dbw.ReadMany<uint32_t>(std::span{keys}, nullptr, snapshot.get())};
+    BOOST_CHECK(old_values == (std::vector<std::optional<uint32_t>>{1, 2, std::nullopt}));
+    const auto new_values{dbw.ReadMany<uint32_t>(std::span{keys})};
+    BOOST_CHECK(new_values == (std::vector<std::optional<uint32_t>>{std::nullopt, 20, 30}));
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
     // Perform tests both obfuscated and non-obfuscated.
@@ -447,15 +447,15 @@ BOOST_FIXTURE_TEST_CASE(miniminer_overlap, TestChain100Setup)
     // tx3's feerate is lower than tx2's. same fee, different weight.
     BOOST_CHECK(tx2_feerate > tx3_feerate);
     const auto tx3_anc_feerate = CFeeRate(low_fee + med_fee + high_fee + high_fee, tx_vsizes[0] + tx_vsizes[1] + tx_vsizes[2] + tx_vsizes[3]);
-    const auto& tx3_entry{*Assert(pool.GetEntry(tx3->GetHash()))};
-    BOOST_CHECK(tx3_anc_feerate == CFeeRate(tx3_entry.GetModFeesWithAncestors(), tx3_entry.GetSizeWithAncestors()));
+    const auto [tx3_anc_count, tx3_anc_size, tx3_anc_fees] = pool.CalculateAncestorData(*Assert(pool.GetEntry(tx3->GetHash())));
+    BOOST_CHECK(tx3_anc_feerate == CFeeRate(tx3_anc_fees, tx3_anc_size));
     const auto tx4_feerate = CFeeRate(high_fee, tx_vsizes[4]);
     const auto tx6_anc_feerate = CFeeRate(high_fee + low_fee + med_fee, tx_vsizes[4] + tx_vsizes[5] + tx_vsizes[6]);
-    const auto& tx6_entry{*Assert(pool.GetEntry(tx6->GetHash()))};
-    BOOST_CHECK(tx6_anc_feerate == CFeeRate(tx6_entry.GetModFeesWithAncestors(), tx6_entry.GetSizeWithAncestors()));
+    const auto [tx6_anc_count, tx6_anc_size, tx6_anc_fees] = pool.CalculateAncestorData(*Assert(pool.GetEntry(tx6->GetHash())));
+    BOOST_CHECK(tx6_anc_feerate == CFeeRate(tx6_anc_fees, tx6_anc_size));
     const auto tx7_anc_feerate = CFeeRate(high_fee + low_fee + high_fee, tx_vsizes[4] + tx_vsizes[5] + tx_vsizes[7]);
-    const auto& tx7_entry{*Assert(pool.GetEntry(tx7->GetHash()))};
-    BOOST_CHECK(tx7_anc_feerate == CFeeRate(tx7_entry.GetModFeesWithAncestors(), tx7_entry.GetSizeWithAncestors()));
+    const auto [tx7_anc_count, tx7_anc_size, tx7_anc_fees] = pool.CalculateAncestorData(*Assert(pool.GetEntry(tx7->GetHash())));
+    BOOST_CHECK(tx7_anc_feerate == CFeeRate(tx7_anc_fees, tx7_anc_size));
     BOOST_CHECK(tx4_feerate > tx6_anc_feerate);
     BOOST_CHECK(tx4_feerate > tx7_anc_feerate);
 
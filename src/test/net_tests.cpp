@@ -1159,6 +1159,15 @@ public:
         m_msg_to_send.push_back(std::move(msg));
     }
 
+    /** Schedule a message with a shared payload to be sent to us by the transport. */
+    void AddSharedMessage(std::string m_type, std::shared_ptr<const SharedNetMsgPayload> payload)
+    {
+        CSerializedNetMsg msg;
+        msg.m_type = std::move(m_type);
+        msg.m_shared_payload = std::move(payload);
+        m_msg_to_send.push_back(std::move(msg));
+    }
+
     /** Expect ellswift key to have been received from transport and process it.
      *
      * Many other V2TransportTester functions cannot be called until after ReceiveKey() has been
@@ -1336,6 +1345,53 @@ public:
 
 } // namespace
 
+BOOST_AUTO_TEST_CASE(v1transport_shared_payload)
+{
+    const auto payload{m_rng.randbytes<uint8_t>(1 + m_rng.randrange(100000))};
+    const auto shared_payload{std::make_shared<const SharedNetMsgPayload>(std::vector{payload})};
+
+    // Send the same payload as a shared and as an unshared message, twice.
+    V1Transport sender{0}, receiver{1};
+    std::vector<uint8_t> sent;
+    for (int i{0}; i < 4; ++i) {
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::BLOCK;
+        if (i % 2 == 0) {
+            msg.m_shared_payload = shared_payload;
+        } else {
+            msg.data = payload;
+        }
+        BOOST_CHECK(msg.GetMemoryUsage() >= payload.size());
+        BOOST_REQUIRE(sender.SetMessageToSend(msg));
+        while (true) {
+            const auto& [bytes, _more, _msg_type] = sender.GetBytesToSend(/*have_next_message=*/false);
+            if (bytes.empty()) break;
+            sent.insert(sent.end(), bytes.begin(), bytes.end());
+            sender.MarkBytesSent(bytes.size());
+        }
+    }
+    // Both are sent as the same bytes...
+    BOOST_REQUIRE_EQUAL(sent.size() % 4, 0U);
+    const std::span sent_span{sent};
+    const size_t msg_size{sent.size() / 4};
+    BOOST_CHECK(std::ranges::equal(sent_span.first(msg_size), sent_span.subspan(msg_size, msg_size)));
+
+    // ...which are received as a valid message.
+    std::span<const uint8_t> to_receive{sent};
+    for (int i{0}; i < 4; ++i) {
+        while (!receiver.ReceivedMessageComplete()) {
+            BOOST_REQUIRE(!to_receive.empty());
+            BOOST_REQUIRE(receiver.ReceivedBytes(to_receive));
+        }
+        bool reject{false};
+        const auto msg{receiver.GetReceivedMessage({}, reject)};
+        BOOST_CHECK(!reject);
+        BOOST_CHECK_EQUAL(msg.m_type, NetMsgType::BLOCK);
+        BOOST_CHECK(std::ranges::equal(msg.m_recv, MakeByteSpan(payload)));
+    }
+    BOOST_CHECK(to_receive.empty());
+}
+
 BOOST_AUTO_TEST_CASE(v2transport_test)
 {
     // A mostly normal scenario, testing a transport in initiator mode.
@@ -1531,11 +1587,17 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
         tester.SendMessage(uint8_t(m_rng.randrange(223) + 33), {}); // unknown short id
         tester.SendMessage(uint8_t(2), msg_data_1); // "block" short id
         tester.AddMessage("blocktxn", msg_data_2); // schedule blocktxn to be sent to us
+        // Shared payloads are sent the same way, with short and long message types.
+        const auto shared_payload{std::make_shared<const SharedNetMsgPayload>(m_rng.randbytes<uint8_t>(m_rng.randrange(100000)))};
+        tester.AddSharedMessage("block", shared_payload);
+        tester.AddSharedMessage("foobaz", shared_payload);
         ret = tester.Interact();
         BOOST_REQUIRE(ret && ret->size() == 2);
         BOOST_CHECK(!(*ret)[0]);
         BOOST_CHECK((*ret)[1] && (*ret)[1]->m_type == "block" && std::ranges::equal((*ret)[1]->m_recv, MakeByteSpan(msg_data_1)));
         tester.ReceiveMessage(uint8_t(3), msg_data_2); // "blocktxn" short id
+        tester.ReceiveMessage(uint8_t(2), shared_payload->data()); // "block" short id
+        tester.ReceiveMessage("foobaz", shared_payload->data());
     }
 
     // Send correct network's V1 header
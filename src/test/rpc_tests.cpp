@@ -7,6 +7,7 @@
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/client.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <test/util/setup_common.h>
@@ -14,7 +15,9 @@
 #include <util/time.h>
 
 #include <any>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -642,4 +645,38 @@ BOOST_AUTO_TEST_CASE(rpc_arg_helper)
     CheckRpc(params, UniValue{JSON(R"([5, "hello", 4, "test", true, 1.23, "world"])")}, check_positional);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    const UniValue value{JSON(R"({"a": [1, "two", {"b\"": null}], "c": {}, "d": [], "e": {"f": [true, false, 1.5]}})")};
+    std::string output;
+    std::vector<size_t> chunk_sizes;
+    JSONStreamWriter out{[&](std::string_view chunk) {
+        output += chunk;
+        chunk_sizes.push_back(chunk.size());
+    }, /*chunk_size=*/8};
+    out.BeginObject();
+    out.Key("a");
+    out.BeginArray();
+    out.Value(1);
+    out.Value("two");
+    out.Value(value["a"][2]);
+    out.EndArray();
+    out.Key("c");
+    out.BeginObject();
+    out.EndObject();
+    out.KeyValue("d", UniValue{UniValue::VARR});
+    out.Key("e");
+    out.BeginObject();
+    out.Members(value["e"]);
+    out.EndObject();
+    out.EndObject();
+    BOOST_CHECK_EQUAL(out.BytesWritten(), value.write().size());
+    out.Flush();
+    // The output is the same as UniValue's, and was handed out in chunks of
+    // at least the chunk size, except for the last.
+    BOOST_CHECK_EQUAL(output, value.write());
+    BOOST_CHECK(chunk_sizes.size() > 1);
+    for (size_t i{0}; i + 1 < chunk_sizes.size(); ++i) BOOST_CHECK_GE(chunk_sizes[i], 8U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
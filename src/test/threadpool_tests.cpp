@@ -0,0 +1,76 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/threadpool.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(threadpool_tests)
+
+BOOST_AUTO_TEST_CASE(submit_and_collect)
+{
+    ThreadPool pool{"test"};
+    pool.Start(/*num_workers=*/3);
+    BOOST_CHECK_EQUAL(pool.WorkersCount(), 3U);
+
+    std::atomic<int> counter{0};
+    std::vector<std::future<int>> futures;
+    for (int i{0}; i < 100; ++i) {
+        futures.emplace_back(pool.Submit([&counter, i] {
+            ++counter;
+            return i * 2;
+        }));
+    }
+    for (int i{0}; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(futures[i].get(), i * 2);
+    }
+    BOOST_CHECK_EQUAL(counter.load(), 100);
+
+    pool.Stop();
+    BOOST_CHECK_EQUAL(pool.WorkersCount(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(exception_is_propagated)
+{
+    ThreadPool pool{"test"};
+    pool.Start(/*num_workers=*/1);
+    auto future{pool.Submit([]() -> int { throw std::runtime_error("fail"); })};
+    BOOST_CHECK_THROW(future.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(stop_discards_queued_tasks)
+{
+    ThreadPool pool{"test"};
+    pool.Start(/*num_workers=*/1);
+
+    // Keep the only worker busy so that the second task stays queued.
+    std::promise<void> started, release;
+    auto blocker{pool.Submit([&started, f = release.get_future()]() mutable {
+        started.set_value();
+        f.wait();
+    })};
+    started.get_future().wait();
+    auto queued{pool.Submit([] {})};
+    BOOST_CHECK_EQUAL(pool.WorkQueueSize(), 1U);
+
+    // Stop() takes the queued task before waiting for the running one.
+    std::thread stopper{[&] { pool.Stop(); }};
+    while (pool.WorkQueueSize() > 0) std::this_thread::yield();
+    release.set_value();
+    stopper.join();
+
+    blocker.get();
+    BOOST_CHECK_THROW(queued.get(), std::future_error);
+
+    // Tasks submitted to a stopped pool are discarded right away.
+    BOOST_CHECK_THROW(pool.Submit([] {}).get(), std::future_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -11,8 +11,13 @@
 
 #include <boost/test/unit_test.hpp>
 
+struct SequentialIndexSyncSetup : public TestChain100Setup {
+    SequentialIndexSyncSetup() : TestChain100Setup{ChainType::REGTEST, {.extra_args = {"-indexsyncthreads=1"}}} {}
+};
+
 BOOST_AUTO_TEST_SUITE(txindex_tests)
 
+// The initial sync prepares blocks on DEFAULT_INDEX_SYNC_THREADS worker threads.
 BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
 {
     TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
@@ -73,4 +78,19 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_sequential_initial_sync, SequentialIndexSyncSetup)
+{
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(txindex.Init());
+    txindex.Sync();
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    txindex.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/txospenderindex.h>
+#include <interfaces/chain.h>
+#include <key.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txospenderindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(txospenderindex_initial_sync_and_reorg, TestChain100Setup)
+{
+    TxoSpenderIndex txospender_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(txospender_index.Init());
+
+    // Spend two coinbase outputs, and the first spend again in the same block,
+    // once the second coinbase output is mature.
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    CreateAndProcessBlock({}, coinbase_script);
+    CKey key{GenerateRandomKey()};
+    const CScript script{GetScriptForDestination(WitnessV0KeyHash(key.GetPubKey()))};
+    CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script, 10 * COIN, /*submit=*/false)};
+    CMutableTransaction respend{CreateValidMempoolTransaction(MakeTransactionRef(spend), 0, 102, key, script, 9 * COIN, /*submit=*/false)};
+    CMutableTransaction other{CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, script, 10 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({spend, respend, other}, coinbase_script);
+
+    const std::vector<COutPoint> outpoints{
+        {m_coinbase_txns[0]->GetHash(), 0},
+        {spend.GetHash(), 0},
+        {m_coinbase_txns[1]->GetHash(), 0},
+        {m_coinbase_txns[2]->GetHash(), 0},
+        {respend.GetHash(), 0},
+    };
+
+    // Nothing is found before the index is started.
+    BOOST_CHECK(!txospender_index.FindSpender(outpoints[0]));
+
+    txospender_index.Sync();
+
+    const auto spender{txospender_index.FindSpender(outpoints[0])};
+    BOOST_REQUIRE(spender);
+    BOOST_CHECK(spender->txid == spend.GetHash());
+    BOOST_CHECK_EQUAL(spender->vin, 0U);
+    BOOST_CHECK_EQUAL(spender->height, 102);
+
+    auto spenders{txospender_index.FindSpenders(outpoints)};
+    BOOST_REQUIRE_EQUAL(spenders.size(), outpoints.size());
+    BOOST_CHECK(spenders[0] && spenders[0]->txid == spend.GetHash());
+    BOOST_CHECK(spenders[1] && spenders[1]->txid == respend.GetHash());
+    BOOST_CHECK(spenders[2] && spenders[2]->txid == other.GetHash());
+    BOOST_CHECK(!spenders[3]);
+    BOOST_CHECK(!spenders[4]);
+    BOOST_CHECK(!txospender_index.FindSpender({m_coinbase_txns[0]->GetHash(), 1}));
+
+    // Replace the block by one spending only the second coinbase output.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    CMutableTransaction replacement{CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 2, coinbaseKey, script, 5 * COIN, /*submit=*/false)};
+    CreateAndProcessBlock({replacement}, coinbase_script);
+    BOOST_REQUIRE(txospender_index.BlockUntilSyncedToCurrentChain());
+
+    spenders = txospender_index.FindSpenders(outpoints);
+    BOOST_CHECK(!spenders[0]);
+    BOOST_CHECK(!spenders[1]);
+    BOOST_CHECK(spenders[2] && spenders[2]->txid == replacement.GetHash() && spenders[2]->height == 102);
+    BOOST_CHECK(!spenders[3]);
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    txospender_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
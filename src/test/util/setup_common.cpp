@@ -269,6 +269,7 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, TestOpts opts)
             .signals = m_node.validation_signals.get(),
             // Use no worker threads while fuzzing to avoid non-determinism
             .worker_threads_num = EnableFuzzDeterminism() ? 0 : 2,
+            .connect_pipeline = m_args.GetBoolArg("-connectpipeline", !EnableFuzzDeterminism()),
         };
         if (opts.min_validation_cache) {
             chainman_opts.script_execution_cache_bytes = 0;
@@ -558,6 +559,21 @@ std::vector<CTransactionRef> TestChain100Setup::PopulateMempool(FastRandomContex
             mtx.vout.emplace_back(amount_per_output, spk);
         }
         CTransactionRef ptx = MakeTransactionRef(mtx);
+        if (submit) {
+            LOCK2(cs_main, m_node.mempool->cs);
+            LockPoints lp;
+            auto changeset = m_node.mempool->GetChangeSet();
+            changeset->StageAddition(ptx, /*fee=*/(total_in - num_outputs * amount_per_output),
+                    /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0,
+                    /*spends_coinbase=*/false, /*sigops_cost=*/4, lp);
+            // Leave out transactions that would grow a cluster past what the
+            // mempool's transaction graph can hold, like validation does.
+            if (!changeset->CheckMemPoolPolicyLimits()) {
+                --num_transactions;
+                continue;
+            }
+            changeset->Apply();
+        }
         mempool_transactions.push_back(ptx);
         if (amount_per_output > 3000) {
             // If the value is high enough to fund another transaction + fees, keep track of it so
@@ -568,15 +584,6 @@ std::vector<CTransactionRef> TestChain100Setup::PopulateMempool(FastRandomContex
                 std::swap(unspent_prevouts.back(), unspent_prevouts[det_rand.randrange(unspent_prevouts.size())]);
             }
         }
-        if (submit) {
-            LOCK2(cs_main, m_node.mempool->cs);
-            LockPoints lp;
-            auto changeset = m_node.mempool->GetChangeSet();
-            changeset->StageAddition(ptx, /*fee=*/(total_in - num_outputs * amount_per_output),
-                    /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0,
-                    /*spends_coinbase=*/false, /*sigops_cost=*/4, lp);
-            changeset->Apply();
-        }
         --num_transactions;
     }
     return mempool_transactions;
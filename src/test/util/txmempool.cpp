@@ -189,19 +189,21 @@ void CheckMempoolTRUCInvariants(const CTxMemPool& tx_pool)
             Assert(entry.GetTxSize() <= TRUC_MAX_VSIZE);
 
             // Check that special TRUC ancestor/descendant limits and rules are always respected
-            Assert(entry.GetCountWithDescendants() <= TRUC_DESCENDANT_LIMIT);
-            Assert(entry.GetCountWithAncestors() <= TRUC_ANCESTOR_LIMIT);
-            Assert(entry.GetSizeWithDescendants() <= TRUC_MAX_VSIZE + TRUC_CHILD_MAX_VSIZE);
-            Assert(entry.GetSizeWithAncestors() <= TRUC_MAX_VSIZE + TRUC_CHILD_MAX_VSIZE);
+            const auto [descendant_count, descendant_size, descendant_fees] = tx_pool.CalculateDescendantData(entry);
+            const auto [ancestor_count, ancestor_size, ancestor_fees] = tx_pool.CalculateAncestorData(entry);
+            Assert(descendant_count <= TRUC_DESCENDANT_LIMIT);
+            Assert(ancestor_count <= TRUC_ANCESTOR_LIMIT);
+            Assert(descendant_size <= TRUC_MAX_VSIZE + TRUC_CHILD_MAX_VSIZE);
+            Assert(ancestor_size <= TRUC_MAX_VSIZE + TRUC_CHILD_MAX_VSIZE);
 
             // If this transaction has at least 1 ancestor, it's a "child" and has restricted weight.
-            if (entry.GetCountWithAncestors() > 1) {
+            if (ancestor_count > 1) {
                 Assert(entry.GetTxSize() <= TRUC_CHILD_MAX_VSIZE);
                 // All TRUC transactions must only have TRUC unconfirmed parents.
                 const auto& parents = entry.GetMemPoolParentsConst();
                 Assert(parents.begin()->get().GetSharedTx()->version == TRUC_VERSION);
             }
-        } else if (entry.GetCountWithAncestors() > 1) {
+        } else if (!entry.GetMemPoolParentsConst().empty()) {
             // All non-TRUC transactions must only have non-TRUC unconfirmed parents.
             for (const auto& parent : entry.GetMemPoolParentsConst()) {
                 Assert(parent.get().GetSharedTx()->version != TRUC_VERSION);
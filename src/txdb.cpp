@@ -75,6 +75,22 @@ bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return m_db->Exists(CoinEntry(&outpoint));
 }
 
+std::vector<std::optional<Coin>> CCoinsViewDB::GetCoins(std::span<const COutPoint> outpoints) const
+{
+    std::vector<CoinEntry> keys;
+    keys.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) keys.emplace_back(&outpoint);
+    return m_db->ReadMany<Coin>(std::span<const CoinEntry>{keys}, m_options.read_pool);
+}
+
+std::vector<std::optional<Coin>> CCoinsViewDB::GetCoins(std::span<const COutPoint> outpoints, const CDBSnapshot& snapshot, ThreadPool* pool) const
+{
+    std::vector<CoinEntry> keys;
+    keys.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) keys.emplace_back(&outpoint);
+    return m_db->ReadMany<Coin>(std::span<const CoinEntry>{keys}, pool, &snapshot);
+}
+
 uint256 CCoinsViewDB::GetBestBlock() const {
     uint256 hashBestChain;
     if (!m_db->Read(DB_BEST_BLOCK, hashBestChain))
@@ -101,10 +117,11 @@ bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashB
         // We may be in the middle of replaying.
         std::vector<uint256> old_heads = GetHeadBlocks();
         if (old_heads.size() == 2) {
-            if (old_heads[0] != hashBlock) {
+            // Partial writes move the new head along with the chain.
+            if (old_heads[0] != hashBlock && old_heads[0] != m_partial_head) {
                 LogPrintLevel(BCLog::COINDB, BCLog::Level::Error, "The coins database detected an inconsistent state, likely due to a previous crash or shutdown. You will need to restart bitcoind with the -reindex-chainstate or -reindex configuration option.\n");
             }
-            assert(old_heads[0] == hashBlock);
+            assert(old_heads[0] == hashBlock || old_heads[0] == m_partial_head);
             old_tip = old_heads[1];
         }
     }
@@ -144,12 +161,27 @@ bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashB
         }
     }
 
+    if (cursor.IsPartial()) {
+        // Only some of the changes up to hashBlock were written. Leave the
+        // database marked as being in transition from old_tip, which it still
+        // can be rolled forward from, as all coins written were modified by
+        // blocks between old_tip and hashBlock.
+        LogDebug(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.ApproximateSize() * (1.0 / 1048576.0));
+        m_db->WriteBatch(batch);
+        m_partial_head = hashBlock;
+        m_partially_written = true;
+        LogDebug(BCLog::COINDB, "Committed %u changed transaction outputs ahead of the next flush to coin database...\n", (unsigned int)changed);
+        return true;
+    }
+
     // In the last batch, mark the database as consistent with hashBlock again.
     batch.Erase(DB_HEAD_BLOCKS);
     batch.Write(DB_BEST_BLOCK, hashBlock);
 
     LogDebug(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.ApproximateSize() * (1.0 / 1048576.0));
     m_db->WriteBatch(batch);
+    m_partial_head.SetNull();
+    m_partially_written = false;
     LogDebug(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return true;
 }
@@ -11,16 +11,19 @@
 #include <kernel/caches.h>
 #include <kernel/cs_main.h>
 #include <sync.h>
+#include <uint256.h>
 #include <util/fs.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
 class COutPoint;
-class uint256;
+class ThreadPool;
 
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
@@ -28,6 +31,8 @@ struct CoinsViewOptions {
     size_t batch_write_bytes{DEFAULT_DB_CACHE_BATCH};
     //! If non-zero, randomly exit when the database is flushed with (1/ratio) probability.
     int simulate_crash_ratio{0};
+    //! Workers to spread the lookups of GetCoins() over, if any. Must outlive the view.
+    ThreadPool* read_pool{nullptr};
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
@@ -37,16 +42,34 @@ protected:
     DBParams m_db_params;
     CoinsViewOptions m_options;
     std::unique_ptr<CDBWrapper> m_db;
+    //! Block that partially written coins were last written for, while the
+    //! database is marked as being in transition to it. Null if the last
+    //! write completed.
+    uint256 m_partial_head;
+    //! Whether m_partial_head is set, for readers not serialized with writes.
+    std::atomic<bool> m_partially_written{false};
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
 
     std::optional<Coin> GetCoin(const COutPoint& outpoint) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
+    std::vector<std::optional<Coin>> GetCoins(std::span<const COutPoint> outpoints) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashBlock) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
+    //! Take a snapshot of the database, to look up coins in later without
+    //! holding cs_main. Must not outlive this view.
+    std::unique_ptr<CDBSnapshot> GetSnapshot() const { return m_db->GetSnapshot(); }
+
+    //! Look up coins in a snapshot taken with GetSnapshot(), spreading the
+    //! lookups over the workers of pool if one is given.
+    std::vector<std::optional<Coin>> GetCoins(std::span<const COutPoint> outpoints, const CDBSnapshot& snapshot, ThreadPool* pool = nullptr) const;
+
+    //! Whether coins have been written that the database is not yet marked consistent with.
+    bool IsPartiallyWritten() const { return m_partially_written; }
+
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
     size_t EstimateSize() const override;
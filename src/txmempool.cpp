@@ -31,7 +31,6 @@
 #include <numeric>
 #include <optional>
 #include <ranges>
-#include <string_view>
 #include <utility>
 
 TRACEPOINT_SEMAPHORE(mempool, added);
@@ -54,76 +53,14 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
     return true;
 }
 
-void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
-                                      const std::set<Txid>& setExclude, std::set<Txid>& descendants_to_remove)
-{
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
-
-    while (!stageEntries.empty()) {
-        const CTxMemPoolEntry& descendant = *stageEntries.begin();
-        descendants.insert(descendant);
-        stageEntries.erase(descendant);
-        const CTxMemPoolEntry::Children& children = descendant.GetMemPoolChildrenConst();
-        for (const CTxMemPoolEntry& childEntry : children) {
-            cacheMap::iterator cacheIt = cachedDescendants.find(mapTx.iterator_to(childEntry));
-            if (cacheIt != cachedDescendants.end()) {
-                // We've already calculated this one, just add the entries for this set
-                // but don't traverse again.
-                for (txiter cacheEntry : cacheIt->second) {
-                    descendants.insert(*cacheEntry);
-                }
-            } else if (!descendants.count(childEntry)) {
-                // Schedule for later processing
-                stageEntries.insert(childEntry);
-            }
-        }
-    }
-    // descendants now contains all in-mempool descendants of updateIt.
-    // Update and add to cached descendant map
-    int32_t modifySize = 0;
-    CAmount modifyFee = 0;
-    int64_t modifyCount = 0;
-    for (const CTxMemPoolEntry& descendant : descendants) {
-        if (!setExclude.count(descendant.GetTx().GetHash())) {
-            modifySize += descendant.GetTxSize();
-            modifyFee += descendant.GetModifiedFee();
-            modifyCount++;
-            cachedDescendants[updateIt].insert(mapTx.iterator_to(descendant));
-            // Update ancestor state for each descendant
-            mapTx.modify(mapTx.iterator_to(descendant), [=](CTxMemPoolEntry& e) {
-              e.UpdateAncestorState(updateIt->GetTxSize(), updateIt->GetModifiedFee(), 1, updateIt->GetSigOpCost());
-            });
-            // Don't directly remove the transaction here -- doing so would
-            // invalidate iterators in cachedDescendants. Mark it for removal
-            // by inserting into descendants_to_remove.
-            if (descendant.GetCountWithAncestors() > uint64_t(m_opts.limits.ancestor_count) || descendant.GetSizeWithAncestors() > m_opts.limits.ancestor_size_vbytes) {
-                descendants_to_remove.insert(descendant.GetTx().GetHash());
-            }
-        }
-    }
-    mapTx.modify(updateIt, [=](CTxMemPoolEntry& e) { e.UpdateDescendantState(modifySize, modifyFee, modifyCount); });
-}
-
 void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<Txid>& vHashesToUpdate)
 {
     AssertLockHeld(cs);
-    // For each entry in vHashesToUpdate, store the set of in-mempool, but not
-    // in-vHashesToUpdate transactions, so that we don't have to recalculate
-    // descendants when we come across a previously seen entry.
-    cacheMap mapMemPoolDescendantsToUpdate;
-
     // Use a set for lookups into vHashesToUpdate (these entries are already
-    // accounted for in the state of their ancestors)
+    // linked to each other)
     std::set<Txid> setAlreadyIncluded(vHashesToUpdate.begin(), vHashesToUpdate.end());
 
-    std::set<Txid> descendants_to_remove;
-
-    // Iterate in reverse, so that whenever we are looking at a transaction
-    // we are sure that all in-mempool descendants have already been processed.
-    // This maximizes the benefit of the descendant cache and guarantees that
-    // CTxMemPoolEntry::m_children will be updated, an assumption made in
-    // UpdateForDescendants.
+    std::vector<const TxGraph::Ref*> updated;
     for (const Txid& hash : vHashesToUpdate | std::views::reverse) {
         // calculate children from mapNextTx
         txiter it = mapTx.find(hash);
@@ -145,12 +82,39 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<Txid>& vHashesToU
                 if (!visited(childIter) && !setAlreadyIncluded.count(childHash)) {
                     UpdateChild(it, childIter, true);
                     UpdateParent(childIter, it, true);
+                    m_txgraph->AddDependency(/*parent=*/*it, /*child=*/*childIter);
                 }
             }
-        } // release epoch guard for UpdateForDescendants
-        UpdateForDescendants(it, mapMemPoolDescendantsToUpdate, setAlreadyIncluded, descendants_to_remove);
+        }
+        updated.push_back(&*it);
     }
 
+    // Reconnecting the re-added transactions to their in-mempool children may
+    // have merged clusters past the cluster limits. Trim() picks transactions
+    // to drop so that every cluster fits again, worst feerates first. It
+    // returns them together with their descendants.
+    if (m_txgraph->IsOversized(TxGraph::Level::MAIN)) {
+        setEntries to_remove;
+        for (TxGraph::Ref* ref : m_txgraph->Trim()) {
+            to_remove.insert(mapTx.iterator_to(static_cast<const CTxMemPoolEntry&>(*ref)));
+        }
+        std::erase_if(updated, [&](const TxGraph::Ref* ref) {
+            return to_remove.count(mapTx.iterator_to(static_cast<const CTxMemPoolEntry&>(*ref)));
+        });
+        RemoveStaged(to_remove, MemPoolRemovalReason::SIZELIMIT);
+    }
+
+    // The children that were in the mempool already may now have more
+    // ancestors than the limits allow.
+    std::vector<Txid> descendants_to_remove;
+    for (TxGraph::Ref* ref : m_txgraph->GetDescendantsUnion(updated, TxGraph::Level::MAIN)) {
+        const auto& descendant{static_cast<const CTxMemPoolEntry&>(*ref)};
+        if (setAlreadyIncluded.count(descendant.GetTx().GetHash())) continue;
+        const auto [count, size, fees] = CalculateAncestorData(descendant);
+        if (count > uint64_t(m_opts.limits.ancestor_count) || size > m_opts.limits.ancestor_size_vbytes) {
+            descendants_to_remove.push_back(descendant.GetTx().GetHash());
+        }
+    }
     for (const auto& txid : descendants_to_remove) {
         // This txid may have been removed already in a prior call to removeRecursive.
         // Therefore we ensure it is not yet removed already.
@@ -158,46 +122,40 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<Txid>& vHashesToU
             removeRecursive((*txiter)->GetTx(), MemPoolRemovalReason::SIZELIMIT);
         }
     }
+    m_txgraph->DoWork(POST_CHANGE_WORK);
 }
 
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimits(
     int64_t entry_size,
     size_t entry_count,
-    CTxMemPoolEntry::Parents& staged_ancestors,
+    const setEntries& parents,
     const Limits& limits) const
 {
-    int64_t totalSizeWithAncestors = entry_size;
-    setEntries ancestors;
-
-    while (!staged_ancestors.empty()) {
-        const CTxMemPoolEntry& stage = staged_ancestors.begin()->get();
-        txiter stageit = mapTx.iterator_to(stage);
-
-        ancestors.insert(stageit);
-        staged_ancestors.erase(stage);
-        totalSizeWithAncestors += stageit->GetTxSize();
-
-        if (stageit->GetSizeWithDescendants() + entry_size > limits.descendant_size_vbytes) {
-            return util::Error{Untranslated(strprintf("exceeds descendant size limit for tx %s [limit: %u]", stageit->GetTx().GetHash().ToString(), limits.descendant_size_vbytes))};
-        } else if (stageit->GetCountWithDescendants() + entry_count > static_cast<uint64_t>(limits.descendant_count)) {
-            return util::Error{Untranslated(strprintf("too many descendants for tx %s [limit: %u]", stageit->GetTx().GetHash().ToString(), limits.descendant_count))};
-        } else if (totalSizeWithAncestors > limits.ancestor_size_vbytes) {
-            return util::Error{Untranslated(strprintf("exceeds ancestor size limit [limit: %u]", limits.ancestor_size_vbytes))};
-        }
+    std::vector<const TxGraph::Ref*> parent_refs;
+    parent_refs.reserve(parents.size());
+    for (txiter parent : parents) parent_refs.push_back(&*parent);
 
-        const CTxMemPoolEntry::Parents& parents = stageit->GetMemPoolParentsConst();
-        for (const CTxMemPoolEntry& parent : parents) {
-            txiter parent_it = mapTx.iterator_to(parent);
+    setEntries ancestors;
+    for (TxGraph::Ref* ref : m_txgraph->GetAncestorsUnion(parent_refs, TxGraph::Level::MAIN)) {
+        ancestors.insert(mapTx.iterator_to(static_cast<const CTxMemPoolEntry&>(*ref)));
+    }
+    if (ancestors.size() + entry_count > static_cast<uint64_t>(limits.ancestor_count)) {
+        return util::Error{Untranslated(strprintf("too many unconfirmed ancestors [limit: %u]", limits.ancestor_count))};
+    }
 
-            // If this is a new ancestor, add it.
-            if (ancestors.count(parent_it) == 0) {
-                staged_ancestors.insert(parent);
-            }
-            if (staged_ancestors.size() + ancestors.size() + entry_count > static_cast<uint64_t>(limits.ancestor_count)) {
-                return util::Error{Untranslated(strprintf("too many unconfirmed ancestors [limit: %u]", limits.ancestor_count))};
-            }
+    int64_t totalSizeWithAncestors = entry_size;
+    for (txiter ancestor : ancestors) {
+        totalSizeWithAncestors += ancestor->GetTxSize();
+        const auto [count_with_descendants, size_with_descendants, fees_with_descendants] = CalculateDescendantData(*ancestor);
+        if (size_with_descendants + entry_size > limits.descendant_size_vbytes) {
+            return util::Error{Untranslated(strprintf("exceeds descendant size limit for tx %s [limit: %u]", ancestor->GetTx().GetHash().ToString(), limits.descendant_size_vbytes))};
+        } else if (count_with_descendants + entry_count > static_cast<uint64_t>(limits.descendant_count)) {
+            return util::Error{Untranslated(strprintf("too many descendants for tx %s [limit: %u]", ancestor->GetTx().GetHash().ToString(), limits.descendant_count))};
         }
     }
+    if (totalSizeWithAncestors > limits.ancestor_size_vbytes) {
+        return util::Error{Untranslated(strprintf("exceeds ancestor size limit [limit: %u]", limits.ancestor_size_vbytes))};
+    }
 
     return ancestors;
 }
@@ -207,7 +165,7 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
 {
     size_t pack_count = package.size();
 
-    // Package itself is busting mempool limits; should be rejected even if no staged_ancestors exist
+    // Package itself is busting mempool limits; should be rejected even if no parents exist
     if (pack_count > static_cast<uint64_t>(m_opts.limits.ancestor_count)) {
         return util::Error{Untranslated(strprintf("package count %u exceeds ancestor count limit [limit: %u]", pack_count, m_opts.limits.ancestor_count))};
     } else if (pack_count > static_cast<uint64_t>(m_opts.limits.descendant_count)) {
@@ -218,13 +176,13 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
         return util::Error{Untranslated(strprintf("package size %u exceeds descendant size limit [limit: %u]", total_vsize, m_opts.limits.descendant_size_vbytes))};
     }
 
-    CTxMemPoolEntry::Parents staged_ancestors;
+    setEntries parents;
     for (const auto& tx : package) {
         for (const auto& input : tx->vin) {
             std::optional<txiter> piter = GetIter(input.prevout.hash);
             if (piter) {
-                staged_ancestors.insert(**piter);
-                if (staged_ancestors.size() + package.size() > static_cast<uint64_t>(m_opts.limits.ancestor_count)) {
+                parents.insert(*piter);
+                if (parents.size() + package.size() > static_cast<uint64_t>(m_opts.limits.ancestor_count)) {
                     return util::Error{Untranslated(strprintf("too many unconfirmed parents [limit: %u]", m_opts.limits.ancestor_count))};
                 }
             }
@@ -234,7 +192,7 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
     // considered together must be within limits even if they are not interdependent. This may be
     // stricter than the limits for each individual transaction.
     const auto ancestors{CalculateAncestorsAndCheckLimits(total_vsize, package.size(),
-                                                          staged_ancestors, m_opts.limits)};
+                                                          parents, m_opts.limits)};
     // It's possible to overestimate the ancestor/descendant totals.
     if (!ancestors.has_value()) return util::Error{Untranslated("possibly " + util::ErrorString(ancestors).original)};
     return {};
@@ -242,77 +200,57 @@ util::Result<void> CTxMemPool::CheckPackageLimits(const Package& package,
 
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
     const CTxMemPoolEntry &entry,
-    const Limits& limits,
-    bool fSearchForParents /* = true */) const
+    const Limits& limits) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
-    const CTransaction &tx = entry.GetTx();
-
-    if (fSearchForParents) {
-        // Get parents of this transaction that are in the mempool
-        // GetMemPoolParents() is only valid for entries in the mempool, so we
-        // iterate mapTx to find parents.
-        for (unsigned int i = 0; i < tx.vin.size(); i++) {
-            std::optional<txiter> piter = GetIter(tx.vin[i].prevout.hash);
-            if (piter) {
-                staged_ancestors.insert(**piter);
-                if (staged_ancestors.size() + 1 > static_cast<uint64_t>(limits.ancestor_count)) {
-                    return util::Error{Untranslated(strprintf("too many unconfirmed parents [limit: %u]", limits.ancestor_count))};
-                }
+    // The entry is not in the mempool yet, so its parents are found by
+    // searching its inputs rather than through its links.
+    setEntries parents;
+    for (const CTxIn& txin : entry.GetTx().vin) {
+        std::optional<txiter> piter = GetIter(txin.prevout.hash);
+        if (piter) {
+            parents.insert(*piter);
+            if (parents.size() + 1 > static_cast<uint64_t>(limits.ancestor_count)) {
+                return util::Error{Untranslated(strprintf("too many unconfirmed parents [limit: %u]", limits.ancestor_count))};
             }
         }
-    } else {
-        // If we're not searching for parents, we require this to already be an
-        // entry in the mempool and use the entry's cached parents.
-        txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
     }
 
-    return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1, staged_ancestors,
+    return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1, parents,
                                             limits);
 }
 
-CTxMemPool::setEntries CTxMemPool::AssumeCalculateMemPoolAncestors(
-    std::string_view calling_fn_name,
-    const CTxMemPoolEntry &entry,
-    const Limits& limits,
-    bool fSearchForParents /* = true */) const
+CTxMemPool::setEntries CTxMemPool::GetAncestors(const CTxMemPoolEntry& entry) const
 {
-    auto result{CalculateMemPoolAncestors(entry, limits, fSearchForParents)};
-    if (!Assume(result)) {
-        LogPrintLevel(BCLog::MEMPOOL, BCLog::Level::Error, "%s: CalculateMemPoolAncestors failed unexpectedly, continuing with empty ancestor set (%s)\n",
-                      calling_fn_name, util::ErrorString(result).original);
+    setEntries ancestors;
+    for (TxGraph::Ref* ref : m_txgraph->GetAncestors(entry, TxGraph::Level::MAIN)) {
+        if (ref == &entry) continue;
+        ancestors.insert(mapTx.iterator_to(static_cast<const CTxMemPoolEntry&>(*ref)));
     }
-    return std::move(result).value_or(CTxMemPool::setEntries{});
+    return ancestors;
 }
 
-void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors)
+namespace {
+std::tuple<uint64_t, int64_t, CAmount> SumEntries(const std::vector<TxGraph::Ref*>& refs)
 {
-    const CTxMemPoolEntry::Parents& parents = it->GetMemPoolParentsConst();
-    // add or remove this tx as a child of each parent
-    for (const CTxMemPoolEntry& parent : parents) {
-        UpdateChild(mapTx.iterator_to(parent), it, add);
-    }
-    const int32_t updateCount = (add ? 1 : -1);
-    const int32_t updateSize{updateCount * it->GetTxSize()};
-    const CAmount updateFee = updateCount * it->GetModifiedFee();
-    for (txiter ancestorIt : setAncestors) {
-        mapTx.modify(ancestorIt, [=](CTxMemPoolEntry& e) { e.UpdateDescendantState(updateSize, updateFee, updateCount); });
+    int64_t size{0};
+    CAmount fees{0};
+    for (const TxGraph::Ref* ref : refs) {
+        const auto& entry{static_cast<const CTxMemPoolEntry&>(*ref)};
+        size += entry.GetTxSize();
+        fees = SaturatingAdd(fees, entry.GetModifiedFee());
     }
+    return {refs.size(), size, fees};
 }
+} // namespace
 
-void CTxMemPool::UpdateEntryForAncestors(txiter it, const setEntries &setAncestors)
+std::tuple<uint64_t, int64_t, CAmount> CTxMemPool::CalculateAncestorData(const CTxMemPoolEntry& entry) const
 {
-    int64_t updateCount = setAncestors.size();
-    int64_t updateSize = 0;
-    CAmount updateFee = 0;
-    int64_t updateSigOpsCost = 0;
-    for (txiter ancestorIt : setAncestors) {
-        updateSize += ancestorIt->GetTxSize();
-        updateFee += ancestorIt->GetModifiedFee();
-        updateSigOpsCost += ancestorIt->GetSigOpCost();
-    }
-    mapTx.modify(it, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(updateSize, updateFee, updateCount, updateSigOpsCost); });
+    return SumEntries(m_txgraph->GetAncestors(entry, TxGraph::Level::MAIN));
+}
+
+std::tuple<uint64_t, int64_t, CAmount> CTxMemPool::CalculateDescendantData(const CTxMemPoolEntry& entry) const
+{
+    return SumEntries(m_txgraph->GetDescendants(entry, TxGraph::Level::MAIN));
 }
 
 void CTxMemPool::UpdateChildrenForRemoval(txiter it)
@@ -323,87 +261,28 @@ void CTxMemPool::UpdateChildrenForRemoval(txiter it)
     }
 }
 
-void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants)
+void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove)
 {
-    // For each entry, walk back all ancestors and decrement size associated with this
-    // transaction
-    if (updateDescendants) {
-        // updateDescendants should be true whenever we're not recursively
-        // removing a tx and all its descendants, eg when a transaction is
-        // confirmed in a block.
-        // Here we only update statistics and not data in CTxMemPool::Parents
-        // and CTxMemPoolEntry::Children (which we need to preserve until we're
-        // finished with all operations that need to traverse the mempool).
-        for (txiter removeIt : entriesToRemove) {
-            setEntries setDescendants;
-            CalculateDescendants(removeIt, setDescendants);
-            setDescendants.erase(removeIt); // don't update state for self
-            int32_t modifySize = -removeIt->GetTxSize();
-            CAmount modifyFee = -removeIt->GetModifiedFee();
-            int modifySigOps = -removeIt->GetSigOpCost();
-            for (txiter dit : setDescendants) {
-                mapTx.modify(dit, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(modifySize, modifyFee, -1, modifySigOps); });
-            }
+    for (txiter removeIt : entriesToRemove) {
+        // Sever the child links that point to removeIt in the entries for its
+        // parents.
+        for (const CTxMemPoolEntry& parent : removeIt->GetMemPoolParentsConst()) {
+            UpdateChild(mapTx.iterator_to(parent), removeIt, false);
         }
     }
-    for (txiter removeIt : entriesToRemove) {
-        const CTxMemPoolEntry &entry = *removeIt;
-        // Since this is a tx that is already in the mempool, we can call CMPA
-        // with fSearchForParents = false.  If the mempool is in a consistent
-        // state, then using true or false should both be correct, though false
-        // should be a bit faster.
-        // However, if we happen to be in the middle of processing a reorg, then
-        // the mempool can be in an inconsistent state.  In this case, the set
-        // of ancestors reachable via GetMemPoolParents()/GetMemPoolChildren()
-        // will be the same as the set of ancestors whose packages include this
-        // transaction, because when we add a new transaction to the mempool in
-        // addNewTransaction(), we assume it has no children, and in the case of a
-        // reorg where that assumption is false, the in-mempool children aren't
-        // linked to the in-block tx's until UpdateTransactionsFromBlock() is
-        // called.
-        // So if we're being called during a reorg, ie before
-        // UpdateTransactionsFromBlock() has been called, then
-        // GetMemPoolParents()/GetMemPoolChildren() will differ from the set of
-        // mempool parents we'd calculate by searching, and it's important that
-        // we use the cached notion of ancestor transactions as the set of
-        // things to update for removal.
-        auto ancestors{AssumeCalculateMemPoolAncestors(__func__, entry, Limits::NoLimits(), /*fSearchForParents=*/false)};
-        // Note that UpdateAncestorsOf severs the child links that point to
-        // removeIt in the entries for the parents of removeIt.
-        UpdateAncestorsOf(false, removeIt, ancestors);
-    }
-    // After updating all the ancestor sizes, we can now sever the link between each
-    // transaction being removed and any mempool children (ie, update CTxMemPoolEntry::m_parents
-    // for each direct child of a transaction being removed).
+    // Sever the link between each transaction being removed and any mempool
+    // children (ie, update CTxMemPoolEntry::m_parents for each direct child of
+    // a transaction being removed).
     for (txiter removeIt : entriesToRemove) {
         UpdateChildrenForRemoval(removeIt);
     }
 }
 
-void CTxMemPoolEntry::UpdateDescendantState(int32_t modifySize, CAmount modifyFee, int64_t modifyCount)
-{
-    nSizeWithDescendants += modifySize;
-    assert(nSizeWithDescendants > 0);
-    nModFeesWithDescendants = SaturatingAdd(nModFeesWithDescendants, modifyFee);
-    m_count_with_descendants += modifyCount;
-    assert(m_count_with_descendants > 0);
-}
-
-void CTxMemPoolEntry::UpdateAncestorState(int32_t modifySize, CAmount modifyFee, int64_t modifyCount, int64_t modifySigOps)
-{
-    nSizeWithAncestors += modifySize;
-    assert(nSizeWithAncestors > 0);
-    nModFeesWithAncestors = SaturatingAdd(nModFeesWithAncestors, modifyFee);
-    m_count_with_ancestors += modifyCount;
-    assert(m_count_with_ancestors > 0);
-    nSigOpCostWithAncestors += modifySigOps;
-    assert(int(nSigOpCostWithAncestors) >= 0);
-}
-
 //! Clamp option values and populate the error if options are not valid.
 static CTxMemPool::Options&& Flatten(CTxMemPool::Options&& opts, bilingual_str& error)
 {
     opts.check_ratio = std::clamp<int>(opts.check_ratio, 0, 1'000'000);
+    opts.limits.cluster_count = std::clamp<int64_t>(opts.limits.cluster_count, 1, MAX_CLUSTER_COUNT_LIMIT);
     int64_t descendant_limit_bytes = opts.limits.descendant_size_vbytes * 40;
     if (opts.max_size_bytes < 0 || opts.max_size_bytes < descendant_limit_bytes) {
         error = strprintf(_("-maxmempool must be at least %d MB"), std::ceil(descendant_limit_bytes / 1'000'000.0));
@@ -414,6 +293,7 @@ static CTxMemPool::Options&& Flatten(CTxMemPool::Options&& opts, bilingual_str&
 CTxMemPool::CTxMemPool(Options opts, bilingual_str& error)
     : m_opts{Flatten(std::move(opts), error)}
 {
+    m_txgraph = MakeTxGraph(m_opts.limits.cluster_count, m_opts.limits.cluster_size_vbytes, ACCEPTABLE_ITERS);
 }
 
 bool CTxMemPool::isSpent(const COutPoint& outpoint) const
@@ -435,23 +315,10 @@ void CTxMemPool::AddTransactionsUpdated(unsigned int n)
 void CTxMemPool::Apply(ChangeSet* changeset)
 {
     AssertLockHeld(cs);
-    RemoveStaged(changeset->m_to_remove, false, MemPoolRemovalReason::REPLACED);
-
-    for (size_t i=0; i<changeset->m_entry_vec.size(); ++i) {
-        auto tx_entry = changeset->m_entry_vec[i];
-        std::optional<CTxMemPool::setEntries> ancestors;
-        if (i == 0) {
-            // Note: ChangeSet::CalculateMemPoolAncestors() will return a
-            // cached value if mempool ancestors for this transaction were
-            // previously calculated.
-            // We can only use a cached ancestor calculation for the first
-            // transaction in a package, because in-package parents won't be
-            // present in the cached ancestor sets of in-package children.
-            // We pass in Limits::NoLimits() to ensure that this function won't fail
-            // (we're going to be applying this set of transactions whether or
-            // not the mempool policy limits are being respected).
-            ancestors = *Assume(changeset->CalculateMemPoolAncestors(tx_entry, Limits::NoLimits()));
-        }
+    if (m_txgraph->HaveStaging()) m_txgraph->CommitStaging();
+    RemoveStaged(changeset->m_to_remove, MemPoolRemovalReason::REPLACED);
+
+    for (auto tx_entry : changeset->m_entry_vec) {
         // First splice this entry into mapTx.
         auto node_handle = changeset->m_to_add.extract(tx_entry);
         auto result = mapTx.insert(std::move(node_handle));
@@ -459,22 +326,13 @@ void CTxMemPool::Apply(ChangeSet* changeset)
         Assume(result.inserted);
         txiter it = result.position;
 
-        // Now update the entry for ancestors/descendants.
-        if (ancestors.has_value()) {
-            addNewTransaction(it, *ancestors);
-        } else {
-            addNewTransaction(it);
-        }
+        // Now link the entry to its in-mempool parents.
+        addNewTransaction(it);
     }
+    m_txgraph->DoWork(POST_CHANGE_WORK);
 }
 
-void CTxMemPool::addNewTransaction(CTxMemPool::txiter it)
-{
-    auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits())};
-    return addNewTransaction(it, ancestors);
-}
-
-void CTxMemPool::addNewTransaction(CTxMemPool::txiter newit, CTxMemPool::setEntries& setAncestors)
+void CTxMemPool::addNewTransaction(CTxMemPool::txiter newit)
 {
     const CTxMemPoolEntry& entry = *newit;
 
@@ -496,12 +354,11 @@ void CTxMemPool::addNewTransaction(CTxMemPool::txiter newit, CTxMemPool::setEntr
     // In that case, our disconnect block logic will call UpdateTransactionsFromBlock
     // to clean up the mess we're leaving here.
 
-    // Update ancestors with information about this tx
+    // Link this tx and its in-mempool parents
     for (const auto& pit : GetIterSet(setParentTransactions)) {
         UpdateParent(newit, pit, true);
+        UpdateChild(pit, newit, true);
     }
-    UpdateAncestorsOf(true, newit, setAncestors);
-    UpdateEntryForAncestors(newit, setAncestors);
 
     nTransactionsUpdated++;
     totalTxSize += entry.GetTxSize();
@@ -577,7 +434,8 @@ void CTxMemPool::CalculateDescendants(txiter entryit, setEntries& setDescendants
     }
     // Traverse down the children of entry, only adding children that are not
     // accounted for in setDescendants already (because those children have either
-    // already been walked, or will be walked in this iteration).
+    // already been walked, or will be walked in this iteration). Unlike a graph
+    // query, this also works while the graph is oversized.
     while (!stage.empty()) {
         txiter it = *stage.begin();
         setDescendants.insert(it);
@@ -621,7 +479,7 @@ void CTxMemPool::removeRecursive(const CTransaction &origTx, MemPoolRemovalReaso
             CalculateDescendants(it, setAllRemoves);
         }
 
-        RemoveStaged(setAllRemoves, false, reason);
+        RemoveStaged(setAllRemoves, reason);
 }
 
 void CTxMemPool::removeForReorg(CChain& chain, std::function<bool(txiter)> check_final_and_mature)
@@ -639,7 +497,7 @@ void CTxMemPool::removeForReorg(CChain& chain, std::function<bool(txiter)> check
     for (txiter it : txToRemove) {
         CalculateDescendants(it, setAllRemoves);
     }
-    RemoveStaged(setAllRemoves, false, MemPoolRemovalReason::REORG);
+    RemoveStaged(setAllRemoves, MemPoolRemovalReason::REORG);
     for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
         assert(TestLockPointValidity(chain, it->GetLockPoints()));
     }
@@ -676,7 +534,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
                 setEntries stage;
                 stage.insert(it);
                 txs_removed_for_block.emplace_back(*it);
-                RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
+                RemoveStaged(stage, MemPoolRemovalReason::BLOCK);
             }
             removeConflicts(*tx);
             ClearPrioritisation(tx->GetHash());
@@ -736,26 +594,17 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         };
         assert(setParentCheck.size() == it->GetMemPoolParentsConst().size());
         assert(std::equal(setParentCheck.begin(), setParentCheck.end(), it->GetMemPoolParentsConst().begin(), comp));
-        // Verify ancestor state is correct.
-        auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits())};
-        uint64_t nCountCheck = ancestors.size() + 1;
-        int32_t nSizeCheck = it->GetTxSize();
-        CAmount nFeesCheck = it->GetModifiedFee();
-        int64_t nSigOpCheck = it->GetSigOpCost();
-
-        for (txiter ancestorIt : ancestors) {
-            nSizeCheck += ancestorIt->GetTxSize();
-            nFeesCheck += ancestorIt->GetModifiedFee();
-            nSigOpCheck += ancestorIt->GetSigOpCost();
+        // Verify the graph's ancestors are the parents and their ancestors.
+        setEntries ancestors_check;
+        for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+            ancestors_check.insert(mapTx.iterator_to(parent));
+            ancestors_check.merge(GetAncestors(parent));
         }
-
-        assert(it->GetCountWithAncestors() == nCountCheck);
-        assert(it->GetSizeWithAncestors() == nSizeCheck);
-        assert(it->GetSigOpCostWithAncestors() == nSigOpCheck);
-        assert(it->GetModFeesWithAncestors() == nFeesCheck);
+        const auto ancestors{GetAncestors(*it)};
+        assert(ancestors == ancestors_check);
         // Sanity check: we are walking in ascending ancestor count order.
-        assert(prev_ancestor_count <= it->GetCountWithAncestors());
-        prev_ancestor_count = it->GetCountWithAncestors();
+        assert(prev_ancestor_count <= ancestors.size() + 1);
+        prev_ancestor_count = ancestors.size() + 1;
 
         // Check children against mapNextTx
         CTxMemPoolEntry::Children setChildrenCheck;
@@ -772,7 +621,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         assert(std::equal(setChildrenCheck.begin(), setChildrenCheck.end(), it->GetMemPoolChildrenConst().begin(), comp));
         // Also check to make sure size is greater than sum with immediate children.
         // just a sanity check, not definitive that this calc is correct...
-        assert(it->GetSizeWithDescendants() >= child_sizes + it->GetTxSize());
+        assert(std::get<1>(CalculateDescendantData(*it)) >= child_sizes + it->GetTxSize());
 
         TxValidationState dummy_state; // Not used. CheckTxInputs() should always pass
         CAmount txfee = 0;
@@ -791,6 +640,13 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+
+    assert(!m_txgraph->HaveStaging());
+    assert(m_txgraph->GetTransactionCount(TxGraph::Level::MAIN) == mapTx.size());
+    for (const auto& entry : mapTx) {
+        assert(m_txgraph->Exists(entry, TxGraph::Level::MAIN));
+    }
+    m_txgraph->SanityCheck();
 }
 
 bool CTxMemPool::CompareDepthAndScore(const Wtxid& hasha, const Wtxid& hashb) const
@@ -805,41 +661,34 @@ bool CTxMemPool::CompareDepthAndScore(const Wtxid& hasha, const Wtxid& hashb) co
     if (!j.has_value()) return false;
     auto i{GetIter(hasha)};
     if (!i.has_value()) return true;
-    uint64_t counta = i.value()->GetCountWithAncestors();
-    uint64_t countb = j.value()->GetCountWithAncestors();
+    const size_t counta{m_txgraph->GetAncestors(*i.value(), TxGraph::Level::MAIN).size()};
+    const size_t countb{m_txgraph->GetAncestors(*j.value(), TxGraph::Level::MAIN).size()};
     if (counta == countb) {
         return CompareTxMemPoolEntryByScore()(*i.value(), *j.value());
     }
     return counta < countb;
 }
 
-namespace {
-class DepthAndScoreComparator
-{
-public:
-    bool operator()(const CTxMemPool::indexed_transaction_set::const_iterator& a, const CTxMemPool::indexed_transaction_set::const_iterator& b)
-    {
-        uint64_t counta = a->GetCountWithAncestors();
-        uint64_t countb = b->GetCountWithAncestors();
-        if (counta == countb) {
-            return CompareTxMemPoolEntryByScore()(*a, *b);
-        }
-        return counta < countb;
-    }
-};
-} // namespace
-
 std::vector<CTxMemPool::indexed_transaction_set::const_iterator> CTxMemPool::GetSortedDepthAndScore() const
 {
-    std::vector<indexed_transaction_set::const_iterator> iters;
+    // Pair each entry with its ancestor count, so it is only looked up once.
+    std::vector<std::pair<size_t, indexed_transaction_set::const_iterator>> counted;
     AssertLockHeld(cs);
 
-    iters.reserve(mapTx.size());
+    counted.reserve(mapTx.size());
 
     for (indexed_transaction_set::iterator mi = mapTx.begin(); mi != mapTx.end(); ++mi) {
-        iters.push_back(mi);
+        counted.emplace_back(m_txgraph->GetAncestors(*mi, TxGraph::Level::MAIN).size(), mi);
     }
-    std::sort(iters.begin(), iters.end(), DepthAndScoreComparator());
+    std::sort(counted.begin(), counted.end(), [](const auto& a, const auto& b) {
+        if (a.first == b.first) {
+            return CompareTxMemPoolEntryByScore()(*a.second, *b.second);
+        }
+        return a.first < b.first;
+    });
+    std::vector<indexed_transaction_set::const_iterator> iters;
+    iters.reserve(counted.size());
+    for (const auto& [_, it] : counted) iters.push_back(it);
     return iters;
 }
 
@@ -894,18 +743,7 @@ void CTxMemPool::PrioritiseTransaction(const Txid& hash, const CAmount& nFeeDelt
         txiter it = mapTx.find(hash);
         if (it != mapTx.end()) {
             mapTx.modify(it, [&nFeeDelta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta); });
-            // Now update all ancestors' modified fees with descendants
-            auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits(), /*fSearchForParents=*/false)};
-            for (txiter ancestorIt : ancestors) {
-                mapTx.modify(ancestorIt, [=](CTxMemPoolEntry& e){ e.UpdateDescendantState(0, nFeeDelta, 0);});
-            }
-            // Now update all descendants' modified fees with ancestors
-            setEntries setDescendants;
-            CalculateDescendants(it, setDescendants);
-            setDescendants.erase(it);
-            for (txiter descendantIt : setDescendants) {
-                mapTx.modify(descendantIt, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDelta, 0, 0); });
-            }
+            m_txgraph->SetTransactionFee(*it, it->GetModifiedFee());
             ++nTransactionsUpdated;
         }
         if (delta == 0) {
@@ -1045,7 +883,7 @@ void CCoinsViewMemPool::Reset()
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(txns_randomized) + m_txgraph->GetMainMemoryUsage() + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const Txid& txid, const bool unchecked) {
@@ -1057,9 +895,9 @@ void CTxMemPool::RemoveUnbroadcastTx(const Txid& txid, const bool unchecked) {
     }
 }
 
-void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
+void CTxMemPool::RemoveStaged(setEntries &stage, MemPoolRemovalReason reason) {
     AssertLockHeld(cs);
-    UpdateForRemoveFromMempool(stage, updateDescendants);
+    UpdateForRemoveFromMempool(stage);
     for (txiter it : stage) {
         removeUnchecked(it, reason);
     }
@@ -1079,7 +917,7 @@ int CTxMemPool::Expire(std::chrono::seconds time)
     for (txiter removeit : toremove) {
         CalculateDescendants(removeit, stage);
     }
-    RemoveStaged(stage, false, MemPoolRemovalReason::EXPIRY);
+    RemoveStaged(stage, MemPoolRemovalReason::EXPIRY);
     return stage.size();
 }
 
@@ -1144,19 +982,23 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+        // The worst chunk is the last one that would be mined. Its
+        // transactions have no in-mempool descendants outside of the chunk.
+        const auto [worst_chunk, feerate] = m_txgraph->GetWorstMainChunk();
 
         // We set the new mempool min fee to the feerate of the removed set, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+        CFeeRate removed(feerate.fee, feerate.size);
         removed += m_opts.incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
         setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+        for (TxGraph::Ref* ref : worst_chunk) {
+            CalculateDescendants(mapTx.iterator_to(static_cast<const CTxMemPoolEntry&>(*ref)), stage);
+        }
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1165,7 +1007,7 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
             for (txiter iter : stage)
                 txn.push_back(iter->GetTx());
         }
-        RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
+        RemoveStaged(stage, MemPoolRemovalReason::SIZELIMIT);
         if (pvNoSpendsRemaining) {
             for (const CTransaction& tx : txn) {
                 for (const CTxIn& txin : tx.vin) {
@@ -1193,7 +1035,7 @@ uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
         if (!counted.insert(candidate).second) continue;
         const CTxMemPoolEntry::Parents& parents = candidate->GetMemPoolParentsConst();
         if (parents.size() == 0) {
-            maximum = std::max(maximum, candidate->GetCountWithDescendants());
+            maximum = std::max<uint64_t>(maximum, m_txgraph->GetDescendants(*candidate, TxGraph::Level::MAIN).size());
         } else {
             for (const CTxMemPoolEntry& i : parents) {
                 candidates.push_back(mapTx.iterator_to(i));
@@ -1208,9 +1050,10 @@ void CTxMemPool::GetTransactionAncestry(const Txid& txid, size_t& ancestors, siz
     auto it = mapTx.find(txid);
     ancestors = descendants = 0;
     if (it != mapTx.end()) {
-        ancestors = it->GetCountWithAncestors();
-        if (ancestorsize) *ancestorsize = it->GetSizeWithAncestors();
-        if (ancestorfees) *ancestorfees = it->GetModFeesWithAncestors();
+        const auto [count, size, fees] = CalculateAncestorData(*it);
+        ancestors = count;
+        if (ancestorsize) *ancestorsize = size;
+        if (ancestorfees) *ancestorfees = fees;
         descendants = CalculateDescendantMaximum(it);
     }
 }
@@ -1258,8 +1101,8 @@ std::optional<std::string> CTxMemPool::CheckConflictTopology(const setEntries& d
 {
     for (const auto& direct_conflict : direct_conflicts) {
         // Ancestor and descendant counts are inclusive of the tx itself.
-        const auto ancestor_count{direct_conflict->GetCountWithAncestors()};
-        const auto descendant_count{direct_conflict->GetCountWithDescendants()};
+        const auto ancestor_count{m_txgraph->GetAncestors(*direct_conflict, TxGraph::Level::MAIN).size()};
+        const auto descendant_count{m_txgraph->GetDescendants(*direct_conflict, TxGraph::Level::MAIN).size()};
         const bool has_ancestor{ancestor_count > 1};
         const bool has_descendant{descendant_count > 1};
         const auto& txid_string{direct_conflict->GetSharedTx()->GetHash().ToString()};
@@ -1279,13 +1122,13 @@ std::optional<std::string> CTxMemPool::CheckConflictTopology(const setEntries& d
         // If we have a parent, we are its only child.
         if (has_descendant) {
             const auto& our_child = direct_conflict->GetMemPoolChildrenConst().begin();
-            if (our_child->get().GetCountWithAncestors() > 2) {
+            if (m_txgraph->GetAncestors(our_child->get(), TxGraph::Level::MAIN).size() > 2) {
                 return strprintf("%s is not the only parent of child %s",
                                  txid_string, our_child->get().GetSharedTx()->GetHash().ToString());
             }
         } else if (has_ancestor) {
             const auto& our_parent = direct_conflict->GetMemPoolParentsConst().begin();
-            if (our_parent->get().GetCountWithDescendants() > 2) {
+            if (m_txgraph->GetDescendants(our_parent->get(), TxGraph::Level::MAIN).size() > 2) {
                 return strprintf("%s is not the only child of parent %s",
                                  txid_string, our_parent->get().GetSharedTx()->GetHash().ToString());
             }
@@ -1297,92 +1140,19 @@ std::optional<std::string> CTxMemPool::CheckConflictTopology(const setEntries& d
 util::Result<std::pair<std::vector<FeeFrac>, std::vector<FeeFrac>>> CTxMemPool::ChangeSet::CalculateChunksForRBF()
 {
     LOCK(m_pool->cs);
-    FeeFrac replacement_feerate{0, 0};
-    for (auto it : m_entry_vec) {
-        replacement_feerate += {it->GetModifiedFee(), it->GetTxSize()};
-    }
-
     auto err_string{m_pool->CheckConflictTopology(m_to_remove)};
     if (err_string.has_value()) {
         // Unsupported topology for calculating a feerate diagram
         return util::Error{Untranslated(err_string.value())};
     }
 
-    // new diagram will have chunks that consist of each ancestor of
-    // direct_conflicts that is at its own fee/size, along with the replacement
-    // tx/package at its own fee/size
-
-    // old diagram will consist of the ancestors and descendants of each element of
-    // all_conflicts.  every such transaction will either be at its own feerate (followed
-    // by any descendant at its own feerate), or as a single chunk at the descendant's
-    // ancestor feerate.
-
-    std::vector<FeeFrac> old_chunks;
-    // Step 1: build the old diagram.
-
-    // The above clusters are all trivially linearized;
-    // they have a strict topology of 1 or two connected transactions.
-
-    // OLD: Compute existing chunks from all affected clusters
-    for (auto txiter : m_to_remove) {
-        // Does this transaction have descendants?
-        if (txiter->GetCountWithDescendants() > 1) {
-            // Consider this tx when we consider the descendant.
-            continue;
-        }
-        // Does this transaction have ancestors?
-        FeeFrac individual{txiter->GetModifiedFee(), txiter->GetTxSize()};
-        if (txiter->GetCountWithAncestors() > 1) {
-            // We'll add chunks for either the ancestor by itself and this tx
-            // by itself, or for a combined package.
-            FeeFrac package{txiter->GetModFeesWithAncestors(), static_cast<int32_t>(txiter->GetSizeWithAncestors())};
-            if (individual >> package) {
-                // The individual feerate is higher than the package, and
-                // therefore higher than the parent's fee. Chunk these
-                // together.
-                old_chunks.emplace_back(package);
-            } else {
-                // Add two points, one for the parent and one for this child.
-                old_chunks.emplace_back(package - individual);
-                old_chunks.emplace_back(individual);
-            }
-        } else {
-            old_chunks.emplace_back(individual);
-        }
+    Assume(m_pool->m_txgraph->HaveStaging());
+    if (m_pool->m_txgraph->IsOversized(TxGraph::Level::TOP)) {
+        return util::Error{Untranslated("cluster size limit exceeded")};
     }
-
-    // No topology restrictions post-chunking; sort
-    std::sort(old_chunks.begin(), old_chunks.end(), std::greater());
-
-    std::vector<FeeFrac> new_chunks;
-
-    /* Step 2: build the NEW diagram
-     * CON = Conflicts of proposed chunk
-     * CNK = Proposed chunk
-     * NEW = OLD - CON + CNK: New diagram includes all chunks in OLD, minus
-     * the conflicts, plus the proposed chunk
-     */
-
-    // OLD - CON: Add any parents of direct conflicts that are not conflicted themselves
-    for (auto direct_conflict : m_to_remove) {
-        // If a direct conflict has an ancestor that is not in all_conflicts,
-        // it can be affected by the replacement of the child.
-        if (direct_conflict->GetMemPoolParentsConst().size() > 0) {
-            // Grab the parent.
-            const CTxMemPoolEntry& parent = direct_conflict->GetMemPoolParentsConst().begin()->get();
-            if (!m_to_remove.contains(m_pool->mapTx.iterator_to(parent))) {
-                // This transaction would be left over, so add to the NEW
-                // diagram.
-                new_chunks.emplace_back(parent.GetModifiedFee(), parent.GetTxSize());
-            }
-        }
-    }
-    // + CNK: Add the proposed chunk itself
-    new_chunks.emplace_back(replacement_feerate);
-
-    // No topology restrictions post-chunking; sort
-    std::sort(new_chunks.begin(), new_chunks.end(), std::greater());
-    return std::make_pair(old_chunks, new_chunks);
+    // The diagrams cover every cluster the changeset touches, before (main)
+    // and after (staging) it is applied, chunked by their linearizations.
+    return m_pool->m_txgraph->GetMainStagingDiagrams();
 }
 
 CTxMemPool::ChangeSet::TxHandle CTxMemPool::ChangeSet::StageAddition(const CTransactionRef& tx, const CAmount fee, int64_t time, unsigned int entry_height, uint64_t entry_sequence, bool spends_coinbase, int64_t sigops_cost, LockPoints lp)
@@ -1394,10 +1164,53 @@ CTxMemPool::ChangeSet::TxHandle CTxMemPool::ChangeSet::StageAddition(const CTran
     m_pool->ApplyDelta(tx->GetHash(), delta);
     if (delta) m_to_add.modify(newit, [&delta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(delta); });
 
+    // Stage the transaction and its dependencies on in-mempool and staged
+    // parents in the graph, where Apply() commits them.
+    TxGraph& txgraph{*m_pool->m_txgraph};
+    if (!txgraph.HaveStaging()) txgraph.StartStaging();
+    m_to_add.modify(newit, [&](CTxMemPoolEntry& e) {
+        static_cast<TxGraph::Ref&>(e) = txgraph.AddTransaction(FeePerWeight(e.GetModifiedFee(), e.GetTxSize()));
+    });
+    for (const CTxIn& txin : tx->vin) {
+        if (auto parent{m_pool->GetIter(txin.prevout.hash)}) {
+            txgraph.AddDependency(/*parent=*/**parent, /*child=*/*newit);
+        } else if (auto staged_parent{m_to_add.find(txin.prevout.hash)}; staged_parent != m_to_add.end()) {
+            txgraph.AddDependency(/*parent=*/*staged_parent, /*child=*/*newit);
+        }
+    }
+
     m_entry_vec.push_back(newit);
     return newit;
 }
 
+void CTxMemPool::ChangeSet::StageRemoval(CTxMemPool::txiter it)
+{
+    LOCK(m_pool->cs);
+    if (!m_pool->m_txgraph->HaveStaging()) m_pool->m_txgraph->StartStaging();
+    m_pool->m_txgraph->RemoveTransaction(*it);
+    m_to_remove.insert(it);
+}
+
+util::Result<void> CTxMemPool::ChangeSet::CheckMemPoolPolicyLimits()
+{
+    LOCK(m_pool->cs);
+    if (m_pool->m_txgraph->HaveStaging() && m_pool->m_txgraph->IsOversized(TxGraph::Level::TOP)) {
+        return util::Error{Untranslated("cluster size limit exceeded")};
+    }
+    return {};
+}
+
+CTxMemPool::ChangeSet::~ChangeSet()
+{
+    LOCK(m_pool->cs);
+    // Drop whatever was staged but not applied. The entries' Refs are
+    // destroyed while the lock is still held.
+    if (m_pool->m_txgraph->HaveStaging()) m_pool->m_txgraph->AbortStaging();
+    m_entry_vec.clear();
+    m_to_add.clear();
+    m_pool->m_have_changeset = false;
+}
+
 void CTxMemPool::ChangeSet::Apply()
 {
     LOCK(m_pool->cs);
@@ -1405,5 +1218,4 @@ void CTxMemPool::ChangeSet::Apply()
     m_to_add.clear();
     m_to_remove.clear();
     m_entry_vec.clear();
-    m_ancestors.clear();
 }
@@ -4,6 +4,7 @@
 #ifndef BITCOIN_UNIVALUE_INCLUDE_UNIVALUE_UTFFILTER_H
 #define BITCOIN_UNIVALUE_INCLUDE_UNIVALUE_UTFFILTER_H
 
+#include <cstddef>
 #include <string>
 
 /**
@@ -45,6 +46,15 @@ public:
                 push_back_u(codepoint);
         }
     }
+    // Write a run of 7-bit ASCII characters
+    void append_ascii(const char* s, size_t n)
+    {
+        if (state == 0) // Fast direct pass-through
+            str.append(s, n);
+        else
+            for (size_t i = 0; i < n; ++i)
+                push_back(static_cast<unsigned char>(s[i]));
+    }
     // Write codepoint directly, possibly collating surrogate pairs
     void push_back_u(unsigned int codepoint_)
     {
@@ -5,10 +5,9 @@
 
 #include <univalue.h>
 
-#include <iomanip>
+#include <charconv>
 #include <map>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -55,31 +54,35 @@ void UniValue::setNumStr(std::string str)
     val = std::move(str);
 }
 
-void UniValue::setInt(uint64_t val_)
+// Integers are formatted with std::to_chars, which is not affected by the
+// locale and always yields a valid JSON number.
+template <typename Int>
+static std::string formatInt(Int val_)
 {
-    std::ostringstream oss;
-
-    oss << val_;
+    char buf[24];
+    return std::string(buf, std::to_chars(buf, buf + sizeof(buf), val_).ptr);
+}
 
-    return setNumStr(oss.str());
+void UniValue::setInt(uint64_t val_)
+{
+    clear();
+    typ = VNUM;
+    val = formatInt(val_);
 }
 
 void UniValue::setInt(int64_t val_)
 {
-    std::ostringstream oss;
-
-    oss << val_;
-
-    return setNumStr(oss.str());
+    clear();
+    typ = VNUM;
+    val = formatInt(val_);
 }
 
 void UniValue::setFloat(double val_)
 {
-    std::ostringstream oss;
-
-    oss << std::setprecision(16) << val_;
-
-    return setNumStr(oss.str());
+    // Same as std::setprecision(16) in the classic locale, which may not be
+    // a valid JSON number for nan and infinity.
+    char buf[32];
+    return setNumStr(std::string(buf, std::to_chars(buf, buf + sizeof(buf), val_, std::chars_format::general, 16).ptr));
 }
 
 void UniValue::setStr(std::string str)
@@ -0,0 +1,142 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/licenses/mit-license.php.
+
+#include "univalue_scan.h"
+
+#include <compat/cpuid.h> // IWYU pragma: keep
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace univalue_scan {
+namespace {
+bool IsPlain(unsigned char ch)
+{
+    return ch >= 0x20 && ch < 0x80 && ch != '"' && ch != '\\';
+}
+
+bool IsUnescaped(unsigned char ch)
+{
+    return ch >= 0x20 && ch != 0x7f && ch != '"' && ch != '\\';
+}
+} // namespace
+
+namespace generic {
+size_t PlainLength(const char* begin, const char* end)
+{
+    const char* it{begin};
+    while (it < end && IsPlain(static_cast<unsigned char>(*it))) ++it;
+    return it - begin;
+}
+
+size_t UnescapedLength(const char* begin, const char* end)
+{
+    const char* it{begin};
+    while (it < end && IsUnescaped(static_cast<unsigned char>(*it))) ++it;
+    return it - begin;
+}
+} // namespace generic
+
+namespace {
+#if defined(__SSE2__)
+// SSE2 is part of the x86-64 baseline, so this needs no runtime check.
+namespace sse2 {
+size_t PlainLength(const char* begin, const char* end)
+{
+    const __m128i quote{_mm_set1_epi8('"')};
+    const __m128i backslash{_mm_set1_epi8('\\')};
+    const __m128i space{_mm_set1_epi8(0x20)};
+    const char* it{begin};
+    for (; end - it >= 16; it += 16) {
+        const __m128i chunk{_mm_loadu_si128(reinterpret_cast<const __m128i*>(it))};
+        // Control characters and non-ASCII bytes are both below space as
+        // signed chars.
+        const __m128i special{_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                           _mm_cmplt_epi8(chunk, space))};
+        const unsigned mask{static_cast<unsigned>(_mm_movemask_epi8(special))};
+        if (mask) return (it - begin) + std::countr_zero(mask);
+    }
+    return (it - begin) + generic::PlainLength(it, end);
+}
+
+size_t UnescapedLength(const char* begin, const char* end)
+{
+    const __m128i quote{_mm_set1_epi8('"')};
+    const __m128i backslash{_mm_set1_epi8('\\')};
+    const __m128i del{_mm_set1_epi8(0x7f)};
+    const __m128i max_control{_mm_set1_epi8(0x1f)};
+    const char* it{begin};
+    for (; end - it >= 16; it += 16) {
+        const __m128i chunk{_mm_loadu_si128(reinterpret_cast<const __m128i*>(it))};
+        // Unsigned chunk <= 0x1f, as there is no unsigned comparison.
+        const __m128i control{_mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk)};
+        const __m128i special{_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                           _mm_or_si128(_mm_cmpeq_epi8(chunk, del), control))};
+        const unsigned mask{static_cast<unsigned>(_mm_movemask_epi8(special))};
+        if (mask) return (it - begin) + std::countr_zero(mask);
+    }
+    return (it - begin) + generic::UnescapedLength(it, end);
+}
+} // namespace sse2
+#endif
+
+struct Implementation {
+    size_t (*plain_length)(const char*, const char*);
+    size_t (*unescaped_length)(const char*, const char*);
+};
+
+#if defined(ENABLE_AVX2) && defined(HAVE_GETCPUID)
+/** Whether the OS saves the AVX registers (XMM and YMM state enabled in XCR0). */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+Implementation AutoDetect()
+{
+#if defined(ENABLE_AVX2) && defined(HAVE_GETCPUID)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave{((ecx >> 27) & 1) != 0};
+    const bool have_avx{((ecx >> 28) & 1) != 0};
+    if (have_xsave && have_avx && AVXEnabled()) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        if ((ebx >> 5) & 1) {
+            return {avx2::PlainLength, avx2::UnescapedLength};
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    return {sse2::PlainLength, sse2::UnescapedLength};
+#else
+    return {generic::PlainLength, generic::UnescapedLength};
+#endif
+}
+
+const Implementation& Selected()
+{
+    static const Implementation implementation{AutoDetect()};
+    return implementation;
+}
+
+} // namespace
+
+size_t PlainLength(const char* begin, const char* end)
+{
+    return Selected().plain_length(begin, end);
+}
+
+size_t UnescapedLength(const char* begin, const char* end)
+{
+    return Selected().unescaped_length(begin, end);
+}
+
+} // namespace univalue_scan
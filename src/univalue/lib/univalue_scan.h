@@ -0,0 +1,46 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UNIVALUE_LIB_UNIVALUE_SCAN_H
+#define BITCOIN_UNIVALUE_LIB_UNIVALUE_SCAN_H
+
+#include <cstddef>
+
+/**
+ * Scanning of the runs of string characters that the reader and the writer
+ * can copy as they are, 16 or 32 bytes at a time where the CPU allows it.
+ * The implementation is picked on first use, based on the CPU features
+ * available at runtime.
+ */
+namespace univalue_scan {
+
+/**
+ * Length of the run at the start of [begin, end) that the reader can copy
+ * into a string value as it is: up to the first quote, backslash, control
+ * character or non-ASCII byte.
+ */
+size_t PlainLength(const char* begin, const char* end);
+
+/**
+ * Length of the run at the start of [begin, end) that the writer can copy
+ * into a JSON string as it is: up to the first character with an entry in
+ * the escapes table.
+ */
+size_t UnescapedLength(const char* begin, const char* end);
+
+namespace generic {
+size_t PlainLength(const char* begin, const char* end);
+size_t UnescapedLength(const char* begin, const char* end);
+} // namespace generic
+
+#if defined(ENABLE_AVX2)
+namespace avx2 {
+size_t PlainLength(const char* begin, const char* end);
+size_t UnescapedLength(const char* begin, const char* end);
+} // namespace avx2
+#endif
+
+} // namespace univalue_scan
+
+#endif // BITCOIN_UNIVALUE_LIB_UNIVALUE_SCAN_H
@@ -0,0 +1,55 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include "univalue_scan.h"
+
+#include <bit>
+#include <cstdint>
+
+#include <immintrin.h>
+
+namespace univalue_scan::avx2 {
+
+size_t PlainLength(const char* begin, const char* end)
+{
+    const __m256i quote{_mm256_set1_epi8('"')};
+    const __m256i backslash{_mm256_set1_epi8('\\')};
+    const __m256i space{_mm256_set1_epi8(0x20)};
+    const char* it{begin};
+    for (; end - it >= 32; it += 32) {
+        const __m256i chunk{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it))};
+        // Control characters and non-ASCII bytes are both below space as
+        // signed chars.
+        const __m256i special{_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                              _mm256_cmpgt_epi8(space, chunk))};
+        const uint32_t mask{static_cast<uint32_t>(_mm256_movemask_epi8(special))};
+        if (mask) return (it - begin) + std::countr_zero(mask);
+    }
+    return (it - begin) + generic::PlainLength(it, end);
+}
+
+size_t UnescapedLength(const char* begin, const char* end)
+{
+    const __m256i quote{_mm256_set1_epi8('"')};
+    const __m256i backslash{_mm256_set1_epi8('\\')};
+    const __m256i del{_mm256_set1_epi8(0x7f)};
+    const __m256i max_control{_mm256_set1_epi8(0x1f)};
+    const char* it{begin};
+    for (; end - it >= 32; it += 32) {
+        const __m256i chunk{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it))};
+        // Unsigned chunk <= 0x1f, as there is no unsigned comparison.
+        const __m256i control{_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, max_control), chunk)};
+        const __m256i special{_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(chunk, del), control))};
+        const uint32_t mask{static_cast<uint32_t>(_mm256_movemask_epi8(special))};
+        if (mask) return (it - begin) + std::countr_zero(mask);
+    }
+    return (it - begin) + generic::UnescapedLength(it, end);
+}
+
+} // namespace univalue_scan::avx2
+
+#endif
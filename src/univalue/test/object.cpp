@@ -7,11 +7,13 @@
 
 #include <cassert>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #define BOOST_CHECK(expr) assert(expr)
@@ -455,6 +457,53 @@ void univalue_readwrite()
     BOOST_CHECK(!v.read("{} 42"));
 }
 
+void univalue_numbers()
+{
+    BOOST_CHECK_EQUAL(UniValue(std::numeric_limits<int64_t>::min()).getValStr(), "-9223372036854775808");
+    BOOST_CHECK_EQUAL(UniValue(std::numeric_limits<uint64_t>::max()).getValStr(), "18446744073709551615");
+    BOOST_CHECK_EQUAL(UniValue(0).getValStr(), "0");
+    BOOST_CHECK_EQUAL(UniValue(0.1).getValStr(), "0.1");
+    BOOST_CHECK_EQUAL(UniValue(1e20).getValStr(), "1e+20");
+    BOOST_CHECK_EQUAL(UniValue(-1.5e-7).getValStr(), "-1.5e-07");
+    BOOST_CHECK_EQUAL(UniValue(1.0 / 3).getValStr(), "0.3333333333333333");
+    BOOST_CHECK_THROW(UniValue(std::numeric_limits<double>::quiet_NaN()), std::runtime_error);
+    BOOST_CHECK_THROW(UniValue(std::numeric_limits<double>::infinity()), std::runtime_error);
+}
+
+// Long strings are scanned many bytes at a time, so check every position
+// of the characters that end such a scan.
+void univalue_long_strings()
+{
+    const std::vector<std::pair<std::string, std::string>> specials{
+        {"\"", "\\\""},
+        {"\\", "\\\\"},
+        {"\n", "\\n"},
+        {std::string(1, '\0'), "\\u0000"},
+        {"\x1f", "\\u001f"},
+        {"\x7f", "\\u007f"},
+        {"\xc3\xa9", "\xc3\xa9"},
+    };
+    for (const auto& [special, escaped] : specials) {
+        for (size_t pos = 0; pos < 80; ++pos) {
+            const std::string str{std::string(pos, 'a') + special + std::string(80 - pos, 'b')};
+            const std::string json{"\"" + std::string(pos, 'a') + escaped + std::string(80 - pos, 'b') + "\""};
+            BOOST_CHECK_EQUAL(UniValue(str).write(), json);
+            UniValue v;
+            BOOST_CHECK(v.read(json));
+            BOOST_CHECK_EQUAL(v.get_str(), str);
+        }
+    }
+    UniValue v;
+    for (size_t pos = 0; pos < 80; ++pos) {
+        // Unescaped control characters are not allowed.
+        BOOST_CHECK(!v.read("\"" + std::string(pos, 'a') + "\t" + std::string(80 - pos, 'b') + "\""));
+        // Neither is a UTF-8 sequence interrupted by ASCII characters.
+        BOOST_CHECK(!v.read("\"" + std::string(pos, 'a') + "\xc3" + std::string(80 - pos, 'b') + "\""));
+        // Nor an unterminated string.
+        BOOST_CHECK(!v.read("\"" + std::string(pos, 'a')));
+    }
+}
+
 int main(int argc, char* argv[])
 {
     univalue_constructor();
@@ -464,5 +513,7 @@ int main(int argc, char* argv[])
     univalue_array();
     univalue_object();
     univalue_readwrite();
+    univalue_numbers();
+    univalue_long_strings();
     return 0;
 }
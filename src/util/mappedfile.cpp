@@ -0,0 +1,52 @@
+// Copyright (c) 2026-present The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/mappedfile.h>
+
+#include <util/fs.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<MappedFile> MappedFile::Open(const fs::path& path)
+{
+#ifdef WIN32
+    // Not implemented: a mapped file could not be deleted by pruning while
+    // the mapping is alive.
+    return nullptr;
+#else
+    const int fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd == -1) return nullptr;
+    struct stat st;
+    void* addr{MAP_FAILED};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+    return std::unique_ptr<MappedFile>{new MappedFile{{static_cast<const std::byte*>(addr), size_t(st.st_size)}, path}};
+#endif
+}
+
+bool MappedFile::Intact() const
+{
+#ifdef WIN32
+    return false;
+#else
+    struct stat st;
+    return stat(m_path.c_str(), &st) == 0 && st.st_size >= 0 && size_t(st.st_size) >= m_data.size();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef WIN32
+    munmap(const_cast<std::byte*>(m_data.data()), m_data.size());
+#endif
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2026-present The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_MAPPEDFILE_H
+#define BITCOIN_UTIL_MAPPEDFILE_H
+
+#include <util/fs.h>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * The mapping stays valid if the file is unlinked, but not if it is truncated:
+ * touching pages past the new end of the file raises SIGBUS. Only map files
+ * that are not going to shrink anymore, and check Intact() before reading in
+ * case they were truncated by someone else.
+ */
+class MappedFile
+{
+public:
+    //! Whether files can be mapped on this platform.
+#ifdef WIN32
+    static constexpr bool SUPPORTED{false};
+#else
+    static constexpr bool SUPPORTED{true};
+#endif
+
+    /**
+     * Map the file at path.
+     *
+     * @returns the mapping, or nullptr if the file cannot be opened, is empty,
+     *          or cannot be mapped.
+     */
+    static std::unique_ptr<MappedFile> Open(const fs::path& path);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const std::byte> data() const { return m_data; }
+    size_t size() const { return m_data.size(); }
+
+    /**
+     * Whether the file on disk still covers the whole mapping, which then can
+     * be read without faulting. This does not protect against the file being
+     * truncated while it is read, or against read errors of the underlying
+     * storage, which raise SIGBUS as well.
+     */
+    bool Intact() const;
+
+private:
+    MappedFile(std::span<const std::byte> data, fs::path path) : m_data{data}, m_path{std::move(path)} {}
+
+    const std::span<const std::byte> m_data;
+    const fs::path m_path;
+};
+
+#endif // BITCOIN_UTIL_MAPPEDFILE_H
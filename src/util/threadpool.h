@@ -0,0 +1,144 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADPOOL_H
+#define BITCOIN_UTIL_THREADPOOL_H
+
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/check.h>
+#include <util/threadnames.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads executing submitted tasks in FIFO order.
+ *
+ * Tasks are submitted with Submit(), which returns a std::future for the
+ * task's result. Exceptions thrown by a task are captured in its future.
+ *
+ * The pool must be started with Start() before tasks are executed. Stop()
+ * waits for the tasks currently running to finish and discards the queued
+ * ones; their futures then report std::future_errc::broken_promise. Tasks
+ * submitted while the pool is not running are discarded the same way.
+ *
+ * Tasks must not block on the result of other tasks submitted to the same
+ * pool, as all workers could end up waiting on work that is never picked up,
+ * unless they run that work themselves when no worker has picked it up yet,
+ * like CDBWrapper::ReadMany() does.
+ */
+class ThreadPool
+{
+private:
+    const std::string m_name;
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::queue<std::packaged_task<void()>> m_work_queue GUARDED_BY(m_mutex);
+    std::vector<std::thread> m_workers GUARDED_BY(m_mutex);
+    bool m_interrupt GUARDED_BY(m_mutex){false};
+
+    void WorkerThread() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (true) {
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_interrupt || !m_work_queue.empty(); });
+            if (m_interrupt) return;
+            auto task{std::move(m_work_queue.front())};
+            m_work_queue.pop();
+            {
+                REVERSE_LOCK(lock, m_mutex);
+                task();
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(std::string name) : m_name{std::move(name)} {}
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() { Stop(); }
+
+    /** Start num_workers worker threads. Must not be called on a running pool. */
+    void Start(int num_workers) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        Assume(m_workers.empty());
+        m_interrupt = false;
+        m_workers.reserve(num_workers);
+        for (int n{0}; n < num_workers; ++n) {
+            m_workers.emplace_back([this, n]() {
+                util::ThreadRename(strprintf("%s.%i", m_name, n));
+                WorkerThread();
+            });
+        }
+    }
+
+    /** Wait for running tasks to finish, discard queued ones and join all workers. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::vector<std::thread> workers;
+        std::queue<std::packaged_task<void()>> discarded;
+        {
+            LOCK(m_mutex);
+            m_interrupt = true;
+            workers.swap(m_workers);
+            discarded.swap(m_work_queue);
+        }
+        m_cv.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    /** Queue fn for execution on a worker thread. */
+    template <typename F>
+    auto Submit(F&& fn) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        using R = std::invoke_result_t<F>;
+        auto promise{std::make_shared<std::promise<R>>()};
+        auto future{promise->get_future()};
+        std::packaged_task<void()> task{[promise, fn = std::forward<F>(fn)]() mutable {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    fn();
+                    promise->set_value();
+                } else {
+                    promise->set_value(fn());
+                }
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        }};
+        {
+            LOCK(m_mutex);
+            if (m_workers.empty()) return future;
+            m_work_queue.push(std::move(task));
+        }
+        m_cv.notify_one();
+        return future;
+    }
+
+    /** Number of tasks waiting to be picked up by a worker. */
+    size_t WorkQueueSize() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        return WITH_LOCK(m_mutex, return m_work_queue.size());
+    }
+
+    /** Number of worker threads. Zero when the pool is not running. */
+    size_t WorkersCount() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        return WITH_LOCK(m_mutex, return m_workers.size());
+    }
+};
+
+#endif // BITCOIN_UTIL_THREADPOOL_H
@@ -68,12 +68,14 @@
 #include <cassert>
 #include <chrono>
 #include <deque>
+#include <future>
 #include <numeric>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
 #include <tuple>
+#include <unordered_set>
 #include <utility>
 
 using kernel::CCoinsStats;
@@ -996,7 +998,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
         CTxMemPool::txiter conflict = *ws.m_iters_conflicting.begin();
 
         maybe_rbf_limits.descendant_count += 1;
-        maybe_rbf_limits.descendant_size_vbytes += conflict->GetSizeWithDescendants();
+        maybe_rbf_limits.descendant_size_vbytes += std::get<1>(m_pool.CalculateDescendantData(*conflict));
     }
 
     if (auto ancestors{m_subpackage.m_changeset->CalculateMemPoolAncestors(ws.m_tx_handle, maybe_rbf_limits)}) {
@@ -1463,6 +1465,14 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
         return MempoolAcceptResult::Failure(ws.m_state);
     }
 
+    // Check that the transaction's cluster, after any replacements, stays within the cluster limits.
+    if (!args.m_bypass_limits) {
+        if (auto cluster_result{m_subpackage.m_changeset->CheckMemPoolPolicyLimits()}; !cluster_result) {
+            ws.m_state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "too-large-cluster", util::ErrorString(cluster_result).original);
+            return MempoolAcceptResult::Failure(ws.m_state);
+        }
+    }
+
     // Perform the inexpensive checks first and avoid hashing and signature verification unless
     // those checks pass, to mitigate CPU exhaustion denial-of-service attacks.
     if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
@@ -1604,6 +1614,12 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         return PackageMempoolAcceptResult(package_state, std::move(results));
     }
 
+    // Check that the clusters of the package, after any replacements, stay within the cluster limits.
+    if (auto cluster_result{m_subpackage.m_changeset->CheckMemPoolPolicyLimits()}; !cluster_result) {
+        package_state.Invalid(PackageValidationResult::PCKG_POLICY, "too-large-cluster", util::ErrorString(cluster_result).original);
+        return PackageMempoolAcceptResult(package_state, std::move(results));
+    }
+
     // Now that we've bounded the resulting possible ancestry count, check package for dust spends
     if (m_pool.m_opts.require_standard) {
         TxValidationState child_state;
@@ -1931,12 +1947,13 @@ CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
 
 CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options)
     : m_dbview{std::move(db_params), std::move(options)},
-      m_catcherview(&m_dbview) {}
+      m_catcherview(&m_dbview),
+      m_prefetchview(&m_catcherview) {}
 
 void CoinsViews::InitCache()
 {
     AssertLockHeld(::cs_main);
-    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview = std::make_unique<CCoinsViewCache>(&m_prefetchview);
 }
 
 Chainstate::Chainstate(
@@ -1949,6 +1966,12 @@ Chainstate::Chainstate(
       m_chainman(chainman),
       m_from_snapshot_blockhash(from_snapshot_blockhash) {}
 
+Chainstate::~Chainstate()
+{
+    // Pipeline work still running in the background references our coins views.
+    for (auto& [_, entry] : m_pipelined_blocks) entry.inputs.wait();
+}
+
 const CBlockIndex* Chainstate::SnapshotBase() const
 {
     if (!m_from_snapshot_blockhash) return nullptr;
@@ -1966,6 +1989,10 @@ void Chainstate::InitCoinsDB(
         leveldb_name += node::SNAPSHOT_CHAINSTATE_SUFFIX;
     }
 
+    // Bulk lookups are made by the input prefetcher on the connect pipeline,
+    // which they are spread over in turn.
+    CoinsViewOptions coins_view_options{m_chainman.m_options.coins_view};
+    coins_view_options.read_pool = &m_chainman.GetConnectPipeline();
     m_coins_views = std::make_unique<CoinsViews>(
         DBParams{
             .path = m_chainman.m_options.datadir / leveldb_name,
@@ -1974,7 +2001,7 @@ void Chainstate::InitCoinsDB(
             .wipe_data = should_wipe,
             .obfuscate = true,
             .options = m_chainman.m_options.coins_db},
-        m_chainman.m_options.coins_view);
+        std::move(coins_view_options));
 
     m_coinsdb_cache_size_bytes = cache_size_bytes;
 }
@@ -1985,6 +2012,7 @@ void Chainstate::InitCoinsCache(size_t cache_size_bytes)
     assert(m_coins_views != nullptr);
     m_coinstip_cache_size_bytes = cache_size_bytes;
     m_coins_views->InitCache();
+    if (m_chainman.m_options.incremental_flush) CoinsTip().EnablePartialSync(INCREMENTAL_FLUSH_MAX_QUEUED);
 }
 
 // Note that though this is marked const, we may end up modifying `m_cached_finished_ibd`, which
@@ -2785,6 +2813,7 @@ bool Chainstate::FlushStateToDisk(
 {
     LOCK(cs_main);
     assert(this->CanFlushToDisk());
+    const auto time_start{SteadyClock::now()};
     std::set<int> setFilesToPrune;
     bool full_flush_completed = false;
 
@@ -2846,7 +2875,7 @@ bool Chainstate::FlushStateToDisk(
         // It's been a while since we wrote the block index and chain state to disk. Do this frequently, so we don't need to redownload or reindex after a crash.
         bool fPeriodicWrite = mode == FlushStateMode::PERIODIC && nNow >= m_next_write;
         // Combine all conditions that result in a write to disk.
-        bool should_write = (mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicWrite || fFlushForPrune;
+        bool should_write = (mode == FlushStateMode::ALWAYS) || (mode == FlushStateMode::FORCE_SYNC) || fCacheLarge || fCacheCritical || fPeriodicWrite || fFlushForPrune;
         // Write blocks, block index and best chain related state to disk.
         if (should_write) {
             LogDebug(BCLog::COINDB, "Writing chainstate to disk: flush mode=%s, prune=%d, large=%d, critical=%d, periodic=%d",
@@ -2905,6 +2934,12 @@ bool Chainstate::FlushStateToDisk(
                     (uint64_t)coins_count,
                     (uint64_t)coins_mem_usage,
                     (bool)fFlushForPrune);
+                const auto held{std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - time_start)};
+                ++m_coins_flush_stats.full_flushes;
+                m_coins_flush_stats.last_full_coins = coins_count;
+                m_coins_flush_stats.last_full_time = held;
+                m_coins_flush_stats.max_full_time = std::max(m_coins_flush_stats.max_full_time, held);
+                LogDebug(BCLog::COINDB, "Flushed %u coins to disk, holding cs_main for %.2fms\n", coins_count, Ticks<MillisecondsDouble>(held));
             }
         }
 
@@ -2923,6 +2958,85 @@ bool Chainstate::FlushStateToDisk(
     return true;
 }
 
+bool Chainstate::FlushCoinsIncrementally(BlockValidationState& state)
+{
+    AssertLockNotHeld(::cs_main);
+    const auto time_start{SteadyClock::now()};
+    CCoinsViewPrefetch* prefetch;
+    int height;
+    node::BlockManager::BlockIndexBatch index_batch;
+    {
+        LOCK(::cs_main);
+        if (m_incremental_flush_blockers > 0 || !m_chain.Tip() || CoinsTip().GetPartialSyncQueueSize() == 0) return true;
+        prefetch = &CoinsPrefetch();
+        height = m_chain.Height();
+        index_batch = m_blockman.TakeBlockIndexBatch();
+        // The coins are only handed over to the prefetch view here, which
+        // serves them in place of the database until they are written below.
+        const auto taken{CoinsTip().SyncPartial(INCREMENTAL_FLUSH_MAX_COINS)};
+        if (!taken) {
+            return FatalError(m_chainman.GetNotifications(), state, _("Failed to write to coin database."));
+        }
+        const auto held{std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - time_start)};
+        if (*taken > 0) {
+            ++m_coins_flush_stats.incremental_flushes;
+            m_coins_flush_stats.incremental_coins += *taken;
+            m_coins_flush_stats.last_incremental_time = held;
+            m_coins_flush_stats.max_incremental_time = std::max(m_coins_flush_stats.max_incremental_time, held);
+        }
+        LogDebug(BCLog::COINDB, "Incrementally flushing %u coins to disk, after holding cs_main for %.2fms (%u queued)\n",
+                 *taken, Ticks<MillisecondsDouble>(held), CoinsTip().GetPartialSyncQueueSize());
+        WITH_LOCK(m_incremental_flush_mutex, m_incremental_flush_writing = true);
+    }
+
+    bool written{true};
+    bool index_written{true};
+    try {
+        // The database is left in transition to the tip, to be rolled
+        // forward to it after a crash, which needs the blocks in between
+        // and their index entries on disk first.
+        if (!m_blockman.FlushChainstateBlockFile(height)) {
+            LogPrintLevel(BCLog::VALIDATION, BCLog::Level::Warning, "%s: Failed to flush block file.\n", __func__);
+        }
+        // A full flush that got in first also wrote the coins handed over above.
+        index_written = m_blockman.WriteBlockIndexBatch(index_batch);
+        if (index_written) written = prefetch->WritePending();
+    } catch (const std::runtime_error& e) {
+        written = false;
+        LogError("%s: %s\n", __func__, e.what());
+    }
+    {
+        LOCK(m_incremental_flush_mutex);
+        m_incremental_flush_writing = false;
+    }
+    m_incremental_flush_cv.notify_all();
+
+    if (!index_written) {
+        LOCK(::cs_main);
+        m_blockman.RequeueBlockIndexBatch(index_batch);
+    }
+    if (!written) {
+        return FatalError(m_chainman.GetNotifications(), state, _("Failed to write to coin database."));
+    }
+    LogDebug(BCLog::COINDB, "Incrementally flushed coins to disk in %.2fms\n", Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+    return true;
+}
+
+void Chainstate::ResetCoinsViews()
+{
+    AssertLockHeld(::cs_main);
+    ResetPipeline();
+    WaitForIncrementalFlush();
+    m_coins_views.reset();
+}
+
+void Chainstate::WaitForIncrementalFlush()
+{
+    // FlushCoinsIncrementally() does not need cs_main to finish its write.
+    WAIT_LOCK(m_incremental_flush_mutex, lock);
+    m_incremental_flush_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_incremental_flush_mutex) { return !m_incremental_flush_writing; });
+}
+
 void Chainstate::ForceFlushStateToDisk()
 {
     BlockValidationState state;
@@ -3018,6 +3132,15 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     CBlockIndex *pindexDelete = m_chain.Tip();
     assert(pindexDelete);
     assert(pindexDelete->pprev);
+    // Coins modified by the block may already have been written, or handed
+    // over to be written, by an incremental flush. Make the database
+    // consistent with the block first, so that it is never left in
+    // transition across branches of a reorg.
+    if ((CoinsPrefetch().GetPendingCount() > 0 || CoinsDB().IsPartiallyWritten()) &&
+        !FlushStateToDisk(state, FlushStateMode::FORCE_SYNC)) {
+        LogError("DisconnectTip(): Failed to flush coins\n");
+        return false;
+    }
     // Read block from disk.
     std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
     CBlock& block = *pblock;
@@ -3115,6 +3238,121 @@ public:
     }
 };
 
+namespace {
+/**
+ * Fulfills a promise once the last reference to it is dropped, that is once
+ * every pipeline task sharing it has either run or been discarded.
+ */
+class CompletionGuard
+{
+    std::promise<void> m_promise;
+
+public:
+    std::future<void> GetFuture() { return m_promise.get_future(); }
+    ~CompletionGuard() { m_promise.set_value(); }
+};
+
+/**
+ * Look up the coins spent by a block on the pipeline workers. CCoinsViewDB
+ * spreads the lookups over the workers in key order.
+ */
+void SubmitInputPrefetch(ThreadPool& pipeline, CCoinsViewPrefetch& prefetch, const CBlock& block, const std::shared_ptr<CompletionGuard>& guard)
+{
+    // Outputs created within the block can't be found in the database.
+    std::unordered_set<Txid, SaltedTxidHasher> created;
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        created.insert(tx->GetHash());
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (!created.contains(txin.prevout.hash)) outpoints.push_back(txin.prevout);
+        }
+    }
+    if (outpoints.empty()) return;
+    pipeline.Submit([&prefetch, guard, outpoints = std::move(outpoints)] {
+        prefetch.Prefetch(outpoints);
+    });
+}
+} // namespace
+
+void Chainstate::PipelineBlock(const CBlockIndex& index, std::shared_ptr<const CBlock> block)
+{
+    AssertLockHeld(::cs_main);
+    ThreadPool& pipeline{m_chainman.GetConnectPipeline()};
+    if (!pipeline.WorkersCount() || !m_coins_views) return;
+    if (m_pipelined_blocks.contains(index.GetBlockHash())) return;
+
+    auto guard{std::make_shared<CompletionGuard>()};
+    PipelinedBlock entry{.height = index.nHeight, .block = {}, .inputs = guard->GetFuture().share()};
+    CCoinsViewPrefetch& prefetch{m_coins_views->m_prefetchview};
+    if (block) {
+        std::promise<std::shared_ptr<const CBlock>> promise;
+        promise.set_value(block);
+        entry.block = promise.get_future().share();
+        SubmitInputPrefetch(pipeline, prefetch, *block, guard);
+    } else {
+        auto promise{std::make_shared<std::promise<std::shared_ptr<const CBlock>>>()};
+        entry.block = promise->get_future().share();
+        pipeline.Submit([&blockman = m_blockman, &pipeline, &prefetch, pos = index.GetBlockPos(), hash = index.GetBlockHash(), promise, guard] {
+            auto pblock{std::make_shared<CBlock>()};
+            if (!blockman.ReadBlock(*pblock, pos, hash)) {
+                promise->set_value(nullptr);
+                return;
+            }
+            promise->set_value(pblock);
+            SubmitInputPrefetch(pipeline, prefetch, *pblock, guard);
+        });
+    }
+    m_pipelined_blocks.emplace(index.GetBlockHash(), std::move(entry));
+}
+
+std::shared_ptr<const CBlock> Chainstate::TakePipelinedBlock(const CBlockIndex& index)
+{
+    AssertLockHeld(::cs_main);
+    std::shared_ptr<const CBlock> block;
+    // Once the inputs are done, the block has been read as well.
+    if (auto it{m_pipelined_blocks.find(index.GetBlockHash())};
+        it != m_pipelined_blocks.end() && it->second.inputs.wait_for(0s) == std::future_status::ready) {
+        try {
+            block = it->second.block.get();
+        } catch (const std::future_error&) {
+            // The pipeline was stopped before the block was read.
+        }
+    }
+    PrunePipeline(index);
+    return block;
+}
+
+void Chainstate::PrunePipeline(const CBlockIndex& index)
+{
+    AssertLockHeld(::cs_main);
+    // Entries the workers are still busy with are kept, so that
+    // ResetPipeline() can wait for them.
+    std::erase_if(m_pipelined_blocks, [&](const auto& item) {
+        const auto& entry{item.second};
+        return entry.height <= index.nHeight && entry.inputs.wait_for(0s) == std::future_status::ready;
+    });
+}
+
+void Chainstate::WaitForPipeline()
+{
+    AssertLockNotHeld(::cs_main);
+    std::vector<std::shared_future<void>> inputs;
+    {
+        LOCK(::cs_main);
+        for (const auto& [_, entry] : m_pipelined_blocks) inputs.push_back(entry.inputs);
+    }
+    for (const auto& done : inputs) done.wait();
+}
+
+void Chainstate::ResetPipeline()
+{
+    AssertLockHeld(::cs_main);
+    for (auto& [_, entry] : m_pipelined_blocks) entry.inputs.wait();
+    m_pipelined_blocks.clear();
+    if (m_coins_views) m_coins_views->m_prefetchview.Clear();
+}
+
 /**
  * Connect a new block to m_chain. block_to_connect is either nullptr or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -3135,13 +3373,19 @@ bool Chainstate::ConnectTip(
     // Read block from disk.
     const auto time_1{SteadyClock::now()};
     if (!block_to_connect) {
-        std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!m_blockman.ReadBlock(*pblockNew, *pindexNew)) {
-            return FatalError(m_chainman.GetNotifications(), state, _("Failed to read block."));
+        if (auto pipelined_block{TakePipelinedBlock(*pindexNew)}) {
+            LogDebug(BCLog::BENCH, "  - Using pipelined block\n");
+            block_to_connect = std::move(pipelined_block);
+        } else {
+            std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+            if (!m_blockman.ReadBlock(*pblockNew, *pindexNew)) {
+                return FatalError(m_chainman.GetNotifications(), state, _("Failed to read block."));
+            }
+            block_to_connect = std::move(pblockNew);
         }
-        block_to_connect = std::move(pblockNew);
     } else {
         LogDebug(BCLog::BENCH, "  - Using cached block\n");
+        PrunePipeline(*pindexNew);
     }
     // Apply the block atomically to the chain state.
     const auto time_2{SteadyClock::now()};
@@ -3347,6 +3591,11 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
 
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : vpindexToConnect | std::views::reverse) {
+            // Read the following block and prefetch its inputs while this one is being connected.
+            if (pindexConnect != pindexMostWork) {
+                const CBlockIndex* pindexNext{pindexMostWork->GetAncestor(pindexConnect->nHeight + 1)};
+                if (pindexNext != pindexMostWork || !pblock) PipelineBlock(*pindexNext);
+            }
             if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
@@ -3460,6 +3709,10 @@ bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<
         // probably have a DEBUG_LOCKORDER test for this in the future.
         if (m_chainman.m_options.signals) LimitValidationInterfaceQueue(*m_chainman.m_options.signals);
 
+        // Let the pipeline finish reading the next block and prefetching its
+        // inputs before cs_main is taken to connect it.
+        WaitForPipeline();
+
         {
             LOCK(cs_main);
             {
@@ -4528,6 +4781,10 @@ bool ChainstateManager::ProcessNewBlock(const std::shared_ptr<const CBlock>& blo
             // Store to disk
             ret = AcceptBlock(block, state, &pindex, force_processing, nullptr, new_block, min_pow_checked);
         }
+        // Start warming the coins cache if the block extends our tip.
+        if (ret && pindex && pindex->pprev == ActiveTip()) {
+            ActiveChainstate().PipelineBlock(*pindex, block);
+        }
         if (!ret) {
             if (m_options.signals) {
                 m_options.signals->BlockChecked(block, state);
@@ -5582,6 +5839,8 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // Resizing reopens the database, which an incremental flush may be writing to.
+    WaitForIncrementalFlush();
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogInfo("[%s] resized coinsdb cache to %.1f MiB",
@@ -6285,6 +6544,23 @@ void ChainstateManager::MaybeRebalanceCaches()
     }
 }
 
+void ChainstateManager::FlushCoinsIncrementally()
+{
+    std::vector<Chainstate*> chainstates;
+    {
+        LOCK(::cs_main);
+        for (Chainstate* chainstate : GetAll()) {
+            if (chainstate->CanFlushToDisk()) chainstates.push_back(chainstate);
+        }
+    }
+    for (Chainstate* chainstate : chainstates) {
+        BlockValidationState state;
+        if (!chainstate->FlushCoinsIncrementally(state)) {
+            LogError("%s: failed to flush coins incrementally (%s)\n", __func__, state.ToString());
+        }
+    }
+}
+
 void ChainstateManager::ResetChainstates()
 {
     m_ibd_chainstate.reset();
@@ -6312,10 +6588,16 @@ ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Opt
       m_blockman{interrupt, std::move(blockman_options)},
       m_validation_cache{m_options.script_execution_cache_bytes, m_options.signature_cache_bytes}
 {
+    if (m_options.connect_pipeline) {
+        m_connect_pipeline.Start(std::clamp(m_options.prefetch_threads_num, 1, MAX_PREFETCH_THREADS));
+    }
 }
 
 ChainstateManager::~ChainstateManager()
 {
+    // Make sure no pipeline work outlives the chainstates it operates on.
+    m_connect_pipeline.Stop();
+
     LOCK(::cs_main);
 
     m_versionbitscache.Clear();
@@ -6383,6 +6665,7 @@ util::Result<void> Chainstate::InvalidateCoinsDBOnDisk()
     fs::path snapshot_datadir = GetSnapshotCoinsDBPath(*this);
 
     // Coins views no longer usable.
+    ResetPipeline();
     m_coins_views.reset();
 
     auto invalid_path = snapshot_datadir + "_INVALID";
@@ -33,13 +33,16 @@
 #include <util/fs.h>
 #include <util/hasher.h>
 #include <util/result.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/translation.h>
 #include <versionbits.h>
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <future>
 #include <map>
 #include <memory>
 #include <optional>
@@ -83,7 +86,13 @@ static constexpr int DEFAULT_CHECKLEVEL{3};
 static const uint64_t MIN_DISK_SPACE_FOR_BLOCK_FILES = 550 * 1024 * 1024;
 
 /** Maximum number of dedicated script-checking threads allowed */
-static constexpr int MAX_SCRIPTCHECK_THREADS{15};
+static constexpr int MAX_SCRIPTCHECK_THREADS{127};
+/** How often modified coins are trickled to disk ahead of the next full flush. */
+static constexpr std::chrono::seconds INCREMENTAL_FLUSH_INTERVAL{1};
+/** Maximum number of coins written by one incremental flush. */
+static constexpr size_t INCREMENTAL_FLUSH_MAX_COINS{50'000};
+/** Maximum number of modified coins remembered for incremental flushes. */
+static constexpr size_t INCREMENTAL_FLUSH_MAX_QUEUED{500'000};
 
 /** Current sync state passed to tip changed callbacks. */
 enum class SynchronizationState {
@@ -454,12 +463,14 @@ enum DisconnectResult
 class ConnectTrace;
 
 /** @see Chainstate::FlushStateToDisk */
-inline constexpr std::array FlushStateModeNames{"NONE", "IF_NEEDED", "PERIODIC", "ALWAYS"};
+inline constexpr std::array FlushStateModeNames{"NONE", "IF_NEEDED", "PERIODIC", "ALWAYS", "FORCE_SYNC"};
 enum class FlushStateMode: uint8_t {
     NONE,
     IF_NEEDED,
     PERIODIC,
-    ALWAYS
+    ALWAYS,
+    //! Write everything, but keep the coins cache.
+    FORCE_SYNC,
 };
 
 /**
@@ -481,6 +492,10 @@ public:
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
+    //! Stages coins looked up ahead of time by the connect pipeline. Internally
+    //! synchronized, as it is filled from background threads.
+    CCoinsViewPrefetch m_prefetchview;
+
     //! This is the top layer of the cache hierarchy - it keeps as many coins in memory as
     //! can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
@@ -563,6 +578,30 @@ protected:
 
     std::optional<const char*> m_last_script_check_reason_logged GUARDED_BY(::cs_main){};
 
+    /** A block being read from disk, and its inputs prefetched, ahead of ConnectTip(). */
+    struct PipelinedBlock {
+        int height;
+        //! Ready once the block has been read; holds nullptr if reading failed.
+        std::shared_future<std::shared_ptr<const CBlock>> block;
+        //! Ready once all lookups for the block's inputs have run or were dropped.
+        std::shared_future<void> inputs;
+    };
+    std::map<uint256, PipelinedBlock> m_pipelined_blocks GUARDED_BY(::cs_main);
+
+    //! Return the block read by the pipeline if its inputs have been prefetched,
+    //! or nullptr otherwise, without waiting for the pipeline. Then prune it.
+    std::shared_ptr<const CBlock> TakePipelinedBlock(const CBlockIndex& index) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    //! Drop the finished pipeline entries for this and lower heights.
+    void PrunePipeline(const CBlockIndex& index) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    //! Wait, without holding cs_main, for the blocks in the pipeline to be
+    //! read and their inputs to be prefetched.
+    void WaitForPipeline() EXCLUSIVE_LOCKS_REQUIRED(!::cs_main);
+
+    //! Wait for any background pipeline work to finish and drop its results.
+    void ResetPipeline() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
 public:
     //! Reference to a BlockManager instance which itself is shared across all
     //! Chainstate instances.
@@ -579,6 +618,12 @@ public:
         ChainstateManager& chainman,
         std::optional<uint256> from_snapshot_blockhash = std::nullopt);
 
+    ~Chainstate();
+
+    //! Prefetch the inputs of the given block on the pipeline workers, reading
+    //! the block from disk first if it is not provided.
+    void PipelineBlock(const CBlockIndex& index, std::shared_ptr<const CBlock> block = nullptr) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     //! Return the current role of the chainstate. See `ChainstateManager`
     //! documentation for a description of the different types of chainstates.
     //!
@@ -651,6 +696,13 @@ public:
         return Assert(m_coins_views)->m_dbview;
     }
 
+    //! @returns A reference to the view staging coins prefetched by the connect pipeline.
+    CCoinsViewPrefetch& CoinsPrefetch() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        AssertLockHeld(::cs_main);
+        return Assert(m_coins_views)->m_prefetchview;
+    }
+
     //! @returns A pointer to the mempool.
     CTxMemPool* GetMempool()
     {
@@ -666,7 +718,7 @@ public:
     }
 
     //! Destructs all objects related to accessing the UTXO set.
-    void ResetCoinsViews() { m_coins_views.reset(); }
+    void ResetCoinsViews() EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_incremental_flush_mutex);
 
     //! Does this chainstate have a UTXO set attached?
     bool HasCoinsViews() const { return (bool)m_coins_views; }
@@ -680,7 +732,7 @@ public:
     //! Resize the CoinsViews caches dynamically and flush state to disk.
     //! @returns true unless an error occurred during the flush.
     bool ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
-        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_incremental_flush_mutex);
 
     /**
      * Update the on-disk chain state.
@@ -701,6 +753,40 @@ public:
     //! Unconditionally flush all changes to disk.
     void ForceFlushStateToDisk();
 
+    /** Statistics about writes of the coins cache to the chainstate database. */
+    struct CoinsFlushStats {
+        //! Incremental flushes that wrote coins, and the number of coins they wrote.
+        uint64_t incremental_flushes{0};
+        uint64_t incremental_coins{0};
+        //! Time cs_main was held by the last and by the longest incremental flush.
+        std::chrono::microseconds last_incremental_time{0};
+        std::chrono::microseconds max_incremental_time{0};
+        //! Flushes that wrote the whole coins cache, and the cache size at the last one.
+        uint64_t full_flushes{0};
+        uint64_t last_full_coins{0};
+        //! Time cs_main was held by the last and by the longest full flush.
+        std::chrono::microseconds last_full_time{0};
+        std::chrono::microseconds max_full_time{0};
+    };
+    CoinsFlushStats GetCoinsFlushStats() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        AssertLockHeld(::cs_main);
+        return m_coins_flush_stats;
+    }
+
+    /**
+     * Write a bounded number of modified coins the database already knows
+     * about, without making it consistent with the tip. They are handed over
+     * to the prefetch view under cs_main, and written to disk after releasing
+     * it, along with the block files and block index entries that are needed
+     * to roll the database forward to the tip after a crash.
+     *
+     * Does nothing while an IncrementalFlushBlocker is alive.
+     *
+     * @returns true unless a system error occurred
+     */
+    bool FlushCoinsIncrementally(BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(!::cs_main, !m_incremental_flush_mutex);
+
     //! Prune blockfiles from the disk if necessary and then flush chainstate changes
     //! if we pruned.
     void PruneAndFlush();
@@ -838,13 +924,44 @@ protected:
 
     NodeClock::time_point m_next_write{NodeClock::time_point::max()};
 
+    CoinsFlushStats m_coins_flush_stats GUARDED_BY(::cs_main);
+
     /**
      * In case of an invalid snapshot, rename the coins leveldb directory so
      * that it can be examined for issue diagnosis.
      */
     [[nodiscard]] util::Result<void> InvalidateCoinsDBOnDisk() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+private:
+    //! Number of IncrementalFlushBlocker objects alive for this chainstate.
+    std::atomic<int> m_incremental_flush_blockers{0};
+
+    //! Whether FlushCoinsIncrementally() is writing without holding cs_main,
+    //! which ResetCoinsViews() has to wait for.
+    Mutex m_incremental_flush_mutex;
+    std::condition_variable m_incremental_flush_cv;
+    bool m_incremental_flush_writing GUARDED_BY(m_incremental_flush_mutex){false};
+    void WaitForIncrementalFlush() EXCLUSIVE_LOCKS_REQUIRED(!m_incremental_flush_mutex);
+
     friend ChainstateManager;
+    friend class IncrementalFlushBlocker;
+};
+
+/**
+ * Holds off incremental flushes of a chainstate for as long as it is alive.
+ * Used while reading the chainstate database outside of cs_main after a full
+ * flush, which would otherwise not be consistent with a single block anymore.
+ */
+class IncrementalFlushBlocker
+{
+public:
+    explicit IncrementalFlushBlocker(Chainstate& chainstate) : m_chainstate{chainstate} { ++m_chainstate.m_incremental_flush_blockers; }
+    ~IncrementalFlushBlocker() { --m_chainstate.m_incremental_flush_blockers; }
+    IncrementalFlushBlocker(const IncrementalFlushBlocker&) = delete;
+    IncrementalFlushBlocker& operator=(const IncrementalFlushBlocker&) = delete;
+
+private:
+    Chainstate& m_chainstate;
 };
 
 enum class SnapshotCompletionResult {
@@ -980,6 +1097,10 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! Workers reading blocks and prefetching their inputs ahead of ConnectTip().
+    //! Only started if the connect pipeline is enabled.
+    ThreadPool m_connect_pipeline{"connpipe"};
+
     //! Timers and counters used for benchmarking validation in both background
     //! and active chainstates.
     SteadyClock::duration GUARDED_BY(::cs_main) time_check{};
@@ -1344,6 +1465,14 @@ public:
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
 
+    //! Write some of the coins modified since the last flush of each chainstate to
+    //! disk, so that the next full flush has less to write.
+    //! Expected to be called every INCREMENTAL_FLUSH_INTERVAL when the
+    //! incremental_flush option is set.
+    //! @see Chainstate::FlushCoinsIncrementally
+    void FlushCoinsIncrementally() EXCLUSIVE_LOCKS_REQUIRED(!::cs_main);
+    ThreadPool& GetConnectPipeline() { return m_connect_pipeline; }
+
     ~ChainstateManager();
 };
 
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+# Copyright (c) The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the address index (-addrindex).
+
+Test that getaddresshistory and the /rest/addresshistory/ endpoint return the
+outputs paying to and the inputs spending from an address, page through long
+histories, and follow reorgs.
+"""
+
+from decimal import Decimal
+import hashlib
+import http.client
+import json
+import urllib.parse
+
+from test_framework.messages import COIN
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+from test_framework.wallet import (
+    MiniWallet,
+    getnewdestination,
+)
+
+
+def script_hash(script_pub_key):
+    return hashlib.sha256(bytes.fromhex(script_pub_key)).digest()[::-1].hex()
+
+
+class AddrIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-addrindex", "-rest"],
+            [],
+        ]
+
+    def run_test(self):
+        self.wallet = MiniWallet(self.nodes[0])
+        self.generate(self.wallet, 110)
+        self.url = urllib.parse.urlparse(self.nodes[0].url)
+
+        self.test_history()
+        self.test_paging()
+        self.test_rest()
+        self.test_reorg()
+        self.test_errors()
+
+    def rest_history(self, target, query=""):
+        conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
+        conn.request("GET", f"/rest/addresshistory/{target}.json{query}")
+        resp = conn.getresponse()
+        body = resp.read().decode("utf-8")
+        return resp.status, body
+
+    def test_history(self):
+        self.log.info("Test outputs paying to and inputs spending from an address")
+        node = self.nodes[0]
+        _, spk, self.address = getnewdestination()
+        self.spk = spk.hex()
+        self.sent = []
+        for amount in [1, 2, 3]:
+            self.sent.append(self.wallet.send_to(from_node=node, scriptPubKey=spk, amount=amount * COIN))
+        self.generate(node, 1)
+        height = node.getblockcount()
+
+        history = node.getaddresshistory(self.address)
+        assert_equal(history["scripthash"], script_hash(self.spk))
+        assert "next" not in history
+        entries = history["history"]
+        assert_equal(len(entries), 3)
+        for entry, sent, amount in zip(sorted(entries, key=lambda e: e["amount"]), self.sent, [1, 2, 3]):
+            assert_equal(entry["txid"], sent["txid"])
+            assert_equal(entry["vout"], sent["sent_vout"])
+            assert_equal(entry["amount"], Decimal(amount))
+            assert_equal(entry["height"], height)
+            assert_equal(entry["blockhash"], node.getbestblockhash())
+            assert_equal(entry["spent"], False)
+            assert "vin" not in entry
+        # The script hash gives the same history.
+        assert_equal(node.getaddresshistory(script_hash(self.spk)), history)
+
+        # Spend from the wallet's address and check the spent flag and the input.
+        utxo = self.wallet.get_utxo()
+        tx = self.wallet.send_self_transfer(from_node=node, utxo_to_spend=utxo)
+        self.generate(node, 1)
+        wallet_history = node.getaddresshistory(self.wallet.get_address(), 0, 1000)["history"]
+        funding = [e for e in wallet_history if e["txid"] == utxo["txid"] and e.get("vout") == utxo["vout"]]
+        assert_equal(len(funding), 1)
+        assert_equal(funding[0]["spent"], True)
+        spending = [e for e in wallet_history if e["txid"] == tx["txid"] and "vin" in e]
+        assert_equal(len(spending), 1)
+        assert_equal(spending[0]["vin"], 0)
+        assert_equal(spending[0]["amount"], utxo["value"])
+        assert "spent" not in spending[0]
+        # Entries are in chain order.
+        positions = [(e["height"], e["position"]) for e in wallet_history]
+        assert_equal(positions, sorted(positions))
+
+    def test_paging(self):
+        self.log.info("Test paging through a history")
+        node = self.nodes[0]
+        address = self.wallet.get_address()
+        full = node.getaddresshistory(address, 0, 1000)["history"]
+        pages = []
+        skip = 0
+        while True:
+            page = node.getaddresshistory(address, skip, 25)
+            pages += page["history"]
+            if "next" not in page:
+                break
+            assert_equal(len(page["history"]), 25)
+            skip = page["next"]
+        assert_equal(pages, full)
+        assert_equal(node.getaddresshistory(address, len(full))["history"], [])
+
+    def test_rest(self):
+        self.log.info("Test the REST endpoint")
+        node = self.nodes[0]
+        status, body = self.rest_history(self.address)
+        assert_equal(status, 200)
+        assert_equal(json.loads(body, parse_float=Decimal), node.getaddresshistory(self.address))
+
+        address = self.wallet.get_address()
+        status, body = self.rest_history(address, "?skip=5&count=10")
+        assert_equal(status, 200)
+        assert_equal(json.loads(body, parse_float=Decimal), node.getaddresshistory(address, 5, 10))
+
+        status, body = self.rest_history("notanaddress")
+        assert_equal(status, 400)
+        status, body = self.rest_history(address, "?count=0")
+        assert_equal(status, 400)
+        status, body = self.rest_history(address, "?count=1001")
+        assert_equal(status, 400)
+        conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
+        conn.request("GET", f"/rest/addresshistory/{address}.bin")
+        assert_equal(conn.getresponse().status, 404)
+
+    def test_reorg(self):
+        self.log.info("Test that a reorg removes the entries of disconnected blocks")
+        node = self.nodes[0]
+        height = node.getblockcount()
+        # Disconnect the blocks of test_history and replace them with empty ones.
+        node.invalidateblock(node.getblockhash(height - 1))
+        self.generateblock(node, self.wallet.get_address(), [], sync_fun=self.no_op)
+        self.generateblock(node, self.wallet.get_address(), [], sync_fun=self.no_op)
+        assert_equal(node.getaddresshistory(self.address)["history"], [])
+        wallet_history = node.getaddresshistory(self.wallet.get_address(), 0, 1000)["history"]
+        assert all(not entry["spent"] for entry in wallet_history)
+        assert all("vout" in entry for entry in wallet_history)
+
+    def test_errors(self):
+        self.log.info("Test errors")
+        node = self.nodes[0]
+        assert_raises_rpc_error(-5, "Invalid address or script hash", node.getaddresshistory, "notanaddress")
+        assert_raises_rpc_error(-8, "count must be between 1 and 1000", node.getaddresshistory, self.address, 0, 0)
+        assert_raises_rpc_error(-8, "Negative skip", node.getaddresshistory, self.address, -1)
+        assert_raises_rpc_error(-1, "Address index is not enabled", self.nodes[1].getaddresshistory, self.address)
+        assert_equal(node.getindexinfo("addrindex"), {"addrindex": {"synced": True, "best_block_height": node.getblockcount()}})
+
+
+if __name__ == '__main__':
+    AddrIndexTest(__file__).main()
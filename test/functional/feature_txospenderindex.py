@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# Copyright (c) The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the spent output index (-txospenderindex).
+
+Test that gettxspendingprevout and the /rest/txospenders/ endpoint return the
+confirmed inputs spending outputs, and follow reorgs.
+"""
+
+import http.client
+import json
+import urllib.parse
+
+from test_framework.messages import (
+    COutPoint,
+    ser_vector,
+)
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+)
+from test_framework.wallet import MiniWallet
+
+
+class TxoSpenderIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-txospenderindex", "-rest"],
+            [],
+        ]
+
+    def run_test(self):
+        self.wallet = MiniWallet(self.nodes[0])
+        self.generate(self.wallet, 110)
+        self.url = urllib.parse.urlparse(self.nodes[0].url)
+
+        self.test_rpc()
+        self.test_rest()
+        self.test_reorg()
+
+    def rest_request(self, path, method="GET", body=""):
+        conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
+        conn.request(method, f"/rest/txospenders{path}", body)
+        resp = conn.getresponse()
+        return resp.status, resp.read()
+
+    def test_rpc(self):
+        self.log.info("Test gettxspendingprevout with confirmed and mempool spends")
+        node = self.nodes[0]
+        self.confirmed_utxo = self.wallet.get_utxo()
+        self.confirmed_tx = self.wallet.send_self_transfer(from_node=node, utxo_to_spend=self.confirmed_utxo)
+        self.block_hash = self.generate(node, 1)[0]
+        self.height = node.getblockcount()
+        mempool_utxo = self.wallet.get_utxo()
+        mempool_tx = self.wallet.send_self_transfer(from_node=node, utxo_to_spend=mempool_utxo)
+        self.unspent = self.wallet.get_utxo(mark_as_spent=False)
+
+        self.outputs = [
+            {"txid": self.confirmed_utxo["txid"], "vout": self.confirmed_utxo["vout"]},
+            {"txid": mempool_utxo["txid"], "vout": mempool_utxo["vout"]},
+            {"txid": self.unspent["txid"], "vout": self.unspent["vout"]},
+        ]
+        result = node.gettxspendingprevout(self.outputs)
+        assert_equal(result, [
+            {**self.outputs[0], "spendingtxid": self.confirmed_tx["txid"], "vin": 0, "height": self.height, "blockhash": self.block_hash},
+            {**self.outputs[1], "spendingtxid": mempool_tx["txid"]},
+            self.outputs[2],
+        ])
+
+        # Without the index, only the mempool is scanned.
+        self.sync_blocks()
+        assert_equal(self.nodes[1].gettxspendingprevout(self.outputs[:1]), self.outputs[:1])
+        assert_equal(node.getindexinfo("txospenderindex"), {"txospenderindex": {"synced": True, "best_block_height": node.getblockcount()}})
+
+    def test_rest(self):
+        self.log.info("Test the REST endpoint")
+        node = self.nodes[0]
+        path = "".join(f"/{o['txid']}-{o['vout']}" for o in self.outputs)
+        status, body = self.rest_request(f"{path}.json")
+        assert_equal(status, 200)
+        result = json.loads(body)
+        assert_equal(result["chainHeight"], node.getblockcount())
+        assert_equal(result["chaintipHash"], node.getbestblockhash())
+        # The mempool spend is not part of the index.
+        assert_equal(result["spenders"], [
+            {**self.outputs[0], "spendingtxid": self.confirmed_tx["txid"], "vin": 0, "height": self.height},
+            self.outputs[1],
+            self.outputs[2],
+        ])
+
+        # Post the outpoints serialized, and check the binary response.
+        outpoints = [COutPoint(int(o["txid"], 16), o["vout"]) for o in self.outputs]
+        status, body = self.rest_request(".bin", "POST", ser_vector(outpoints))
+        assert_equal(status, 200)
+        assert_equal(int.from_bytes(body[0:4], "little"), node.getblockcount())
+        assert_equal(body[4:36][::-1].hex(), node.getbestblockhash())
+        assert_equal(body[36:38], bytes([1, 0b001]))
+        assert_equal(body[38], 1)
+        assert_equal(body[39:71][::-1].hex(), self.confirmed_tx["txid"])
+        assert_equal(int.from_bytes(body[71:75], "little"), 0)
+        assert_equal(int.from_bytes(body[75:79], "little"), self.height)
+        assert_equal(len(body), 79)
+
+        status, hex_body = self.rest_request(".hex", "POST", ser_vector(outpoints).hex())
+        assert_equal(status, 200)
+        assert_equal(hex_body.decode().strip(), body.hex())
+
+        self.log.info("Test REST errors")
+        assert_equal(self.rest_request(".json")[0], 400)
+        assert_equal(self.rest_request("/notanoutpoint.json")[0], 400)
+        assert_equal(self.rest_request(f"{path}.bin", "POST", ser_vector(outpoints))[0], 400)
+        too_many = ser_vector([outpoints[0]] * 10001)
+        assert_equal(self.rest_request(".bin", "POST", too_many)[0], 400)
+
+    def test_reorg(self):
+        self.log.info("Test that a reorg removes the spends of disconnected blocks")
+        node = self.nodes[0]
+        node.invalidateblock(self.block_hash)
+        self.generateblock(node, self.wallet.get_address(), [], sync_fun=self.no_op)
+        node.syncwithvalidationinterfacequeue()
+        result = node.gettxspendingprevout(self.outputs[:1])
+        # The disconnected spend went back to the mempool.
+        assert_equal(result, [{**self.outputs[0], "spendingtxid": self.confirmed_tx["txid"]}])
+        status, body = self.rest_request(f"/{self.outputs[0]['txid']}-{self.outputs[0]['vout']}.json")
+        assert_equal(status, 200)
+        assert_equal(json.loads(body)["spenders"], self.outputs[:1])
+
+
+if __name__ == '__main__':
+    TxoSpenderIndexTest(__file__).main()
@@ -237,5 +237,37 @@ class HTTPBasicsTest (BitcoinTestFramework):
         conn.request('GET', '/')
         conn.getresponse()
 
+        self.log.info("Check -rpcclientthreads")
+        # The rpcauth user "rt" has password "cA773lm788buwYe4g4WT+05pKyNruVKjQ25x3n0DQcM="
+        rpcauth = "rt:93648e835a54c573682c2eb19f882535$7681e9c5b74bdd85e78166031d2058e1069b3ed7ed967c93fc63abba06f31144"
+        self.restart_node(2, extra_args=["-rpcthreads=2", "-rpcclientthreads=1", f"-rpcauth={rpcauth}"])
+        tip_height = self.nodes[2].getblockcount()
+        address = self.nodes[2].get_deterministic_priv_key().address
+        # The cookie changed on restart.
+        urlNode2 = urllib.parse.urlparse(self.nodes[2].url)
+        req = "POST / HTTP/1.1\r\n"
+        req += f'Authorization: Basic {str_to_b64str(f"{urlNode2.username}:{urlNode2.password}")}\r\n'
+        # Two slow requests of the default user, of which only one may run.
+        slow_socks = []
+        for _ in range(2):
+            conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port)
+            conn.connect()
+            body = f'{{"method": "waitforblockheight", "params": [{tip_height + 1}]}}'
+            conn.sock.sendall((req + f'Content-Length: {len(body)}\r\n\r\n' + body).encode("utf-8"))
+            slow_socks.append(conn.sock)
+        # The other worker stays free for the requests of another user.
+        headers_rt = {"Authorization": f"Basic {str_to_b64str('rt:cA773lm788buwYe4g4WT+05pKyNruVKjQ25x3n0DQcM=')}"}
+        conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port, timeout=10)
+        conn.request('POST', '/', '{"method": "getblockcount"}', headers_rt)
+        assert_equal(conn.getresponse().read(), f'{{"result":{tip_height},"error":null}}\n'.encode())
+        conn.request('POST', '/', f'{{"method": "generatetoaddress", "params": [1, "{address}"]}}', headers_rt)
+        assert b'"error":null' in conn.getresponse().read()
+        for sock in slow_socks:
+            sock.settimeout(10)
+            res = b""
+            while b"result" not in res:
+                res += sock.recv(1024)
+            assert b'"error":null' in res
+
 if __name__ == '__main__':
     HTTPBasicsTest(__file__).main()
@@ -16,7 +16,11 @@ import urllib.parse
 from test_framework.messages import (
     BLOCK_HEADER_SIZE,
     COIN,
+    COutPoint,
+    CTxOut,
     deser_block_spent_outputs,
+    deser_compact_size,
+    ser_vector,
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -220,6 +224,47 @@ class RESTTest (BitcoinTestFramework):
         long_uri = '/'.join([f'{txid}-{n_}' for n_ in range(15)])
         self.test_rest_request(f"/getutxos/checkmempool/{long_uri}", http_method='POST', status=200)
 
+        self.log.info("Test the /bulkutxos URI")
+        # Most outputs of the pre-mined chain have not been looked up since
+        # startup and are read from the coins database, while the ones just
+        # created are in the coins cache.
+        outpoints = [(self.nodes[0].getblock(self.nodes[0].getblockhash(h))['tx'][0], 0) for h in range(1, 11)]
+        outpoints += [spending, spent] + [(spent[0], n_) for n_ in range(1000, 3000)]
+        body = ser_vector([COutPoint(int(txid_, 16), n_) for txid_, n_ in outpoints])
+        bin_response = self.test_rest_request("/bulkutxos", http_method='POST', req_type=ReqType.BIN, body=body, ret_type=RetType.BYTES)
+        hex_response = self.test_rest_request("/bulkutxos", http_method='POST', req_type=ReqType.HEX, body=body.hex(), ret_type=RetType.BYTES)
+        assert_equal(hex_response.decode().strip(), bin_response.hex())
+        f = BytesIO(bin_response)
+        assert_equal(int.from_bytes(f.read(4), 'little'), self.nodes[0].getblockcount())
+        assert_equal(f.read(32)[::-1].hex(), self.nodes[0].getbestblockhash())
+        bitmap = f.read(deser_compact_size(f))
+        coins = []
+        for _ in range(deser_compact_size(f)):
+            f.read(4)
+            height = int.from_bytes(f.read(4), 'little')
+            out = CTxOut()
+            out.deserialize(f)
+            coins.append((height, out))
+        assert_equal(f.read(), b'')
+        hits = [bool(bitmap[i // 8] >> (i % 8) & 1) for i in range(len(outpoints))]
+        assert_equal(len(coins), sum(hits))
+        assert not any(hits[12:])
+        # The results match /getutxos, which looks up the coins in the cache.
+        expected = self.test_rest_request("/getutxos/" + "/".join(f"{txid_}-{n_}" for txid_, n_ in outpoints[:12]))
+        assert_equal(bitmap[0] | bitmap[1] << 8, int(expected['bitmap'][::-1], 2))
+        assert hits[10]
+        for (height, out), utxo in zip(coins, expected['utxos']):
+            assert_equal(height, utxo['height'])
+            assert_equal(out.nValue, int(utxo['value'] * COIN))
+            assert_equal(out.scriptPubKey.hex(), utxo['scriptPubKey']['hex'])
+
+        self.test_rest_request("/bulkutxos", http_method='POST', req_type=ReqType.BIN, body=b'\x00', status=400, ret_type=RetType.OBJ)
+        self.test_rest_request("/bulkutxos", http_method='POST', req_type=ReqType.BIN, body=body[:-1], status=400, ret_type=RetType.OBJ)
+        self.test_rest_request("/bulkutxos", http_method='POST', req_type=ReqType.JSON, body=body, status=404, ret_type=RetType.OBJ)
+        self.test_rest_request(f"/bulkutxos/{spending[0]}-{spending[1]}", req_type=ReqType.BIN, status=400, ret_type=RetType.OBJ)
+        too_many = ser_vector([COutPoint(int(spent[0], 16), n_) for n_ in range(100001)])
+        self.test_rest_request("/bulkutxos", http_method='POST', req_type=ReqType.BIN, body=too_many, status=400, ret_type=RetType.OBJ)
+
         self.generate(self.nodes[0], 1)  # generate block to not affect upcoming tests
 
         self.log.info("Test the /block, /blockhashbyheight, /headers, and /blockfilterheaders URIs")
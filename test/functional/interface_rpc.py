@@ -7,8 +7,10 @@
 import json
 import os
 from dataclasses import dataclass
+from test_framework.blocktools import COINBASE_MATURITY
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal, assert_greater_than_or_equal
+from test_framework.wallet import MiniWallet
 from threading import Thread
 from typing import Optional
 import subprocess
@@ -238,10 +240,32 @@ class RPCInterfaceTest(BitcoinTestFramework):
         for t in threads:
             t.join()
 
+    def test_streamed_results(self):
+        self.log.info("Testing results streamed in chunked replies...")
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+        self.generate(wallet, COINBASE_MATURITY + 50)
+        for _ in range(50):
+            wallet.send_self_transfer(from_node=node)
+        calls = [("getrawmempool", [True])]
+        blockhash = self.generate(node, 1)[0]
+        calls += [("getblock", [blockhash, verbosity]) for verbosity in (1, 2, 3)]
+        for method, params in calls:
+            for version in (1, 2):
+                # Single requests stream their result, while batches do not.
+                request = format_request(BatchOptions(version), 0, {"method": method, "params": params})
+                response, status = send_json_rpc(node, request)
+                assert_equal(status, 200)
+                batch_response, _ = send_json_rpc(node, [request])
+                assert_equal(response, batch_response[0])
+                assert_equal(response["result"], getattr(node, method)(*params))
+        assert_equal(len(response["result"]["tx"]), 51)
+
     def run_test(self):
         self.test_getrpcinfo()
         self.test_batch_requests()
         self.test_http_status_codes()
+        self.test_streamed_results()
         self.test_work_queue_exceeded()
 
 
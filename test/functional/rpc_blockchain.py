@@ -141,9 +141,11 @@ class BlockchainTest(BitcoinTestFramework):
             'blocks',
             'chain',
             'chainwork',
+            'coinsflush',
             'difficulty',
             'headers',
             'initialblockdownload',
+            'inputprefetch',
             'mediantime',
             'pruned',
             'size_on_disk',
@@ -163,6 +165,14 @@ class BlockchainTest(BitcoinTestFramework):
         # size_on_disk should be > 0
         assert_greater_than(res['size_on_disk'], 0)
 
+        # the block input prefetcher is enabled by default
+        assert_equal(res['inputprefetch']['threads'], 4)
+        assert_greater_than_or_equal(res['inputprefetch']['lookups'], res['inputprefetch']['hits'] + res['inputprefetch']['wasted'])
+
+        # coins are flushed incrementally by default
+        assert res['coinsflush']['incremental']
+        assert_greater_than_or_equal(res['coinsflush']['max_full_ms'], res['coinsflush']['last_full_ms'])
+
         # pruneheight should be greater or equal to 0
         assert_greater_than_or_equal(res['pruneheight'], 0)
 
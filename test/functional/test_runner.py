@@ -346,6 +346,8 @@ BASE_SCRIPTS = [
     'interface_ipc.py',
     'feature_anchors.py',
     'mempool_datacarrier.py',
+    'feature_addrindex.py',
+    'feature_txospenderindex.py',
     'feature_coinstatsindex.py',
     'feature_coinstatsindex_compatibility.py',
     'wallet_orphanedreward.py',